@@ -0,0 +1,147 @@
+#include "matrix_operations.h"
+#include "order.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// ========== Замеры плотных матричных операций по реализациям ==========
+// bench_matrix [--ublas-all] [n ...]  (по умолчанию n = 500 2000)
+// Для каждой доступной MatrixBackend: время и GFLOP/s умножения, разложения
+// Холецкого, треугольных решений, обращения и плотного взвешенного МНК
+// (MleastSquare_weight по ковариации порядковых статистик ordern_matrix).
+// uBLAS медленный (O(n³) без блоков), поэтому по умолчанию замеряется только
+// при n <= BENCH_UBLAS_MAX; обращение вне LAPACK (LU uBLAS) - при n <= BENCH_INVERSE_MAX.
+
+static const int BENCH_UBLAS_MAX = 1000;
+static const int BENCH_INVERSE_MAX = 500;
+static const double BENCH_MIN_SECONDS = 0.2;
+
+/**
+ * Лучшее время одного вызова: повторы, пока суммарно не наберется BENCH_MIN_SECONDS
+ * (не менее одного). prepare выполняется перед каждым повтором и не замеряется.
+ */
+static double best_seconds(const std::function<void()>& prepare, const std::function<void()>& run) {
+    typedef std::chrono::steady_clock Clock;
+    double best = 1e300, total = 0.0;
+    do {
+        prepare();
+        Clock::time_point start = Clock::now();
+        run();
+        double t = std::chrono::duration<double>(Clock::now() - start).count();
+        best = std::min(best, t);
+        total += t;
+    } while (total < BENCH_MIN_SECONDS);
+    return best;
+}
+
+static Matrix filled_matrix(int rows, int cols, double seed) {
+    Matrix a(rows, cols);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) a(i, j) = std::sin(seed + 0.37 * i + 0.11 * j);
+    }
+    return a;
+}
+
+static const char* backend_name(MatrixBackend backend) {
+    switch (backend) {
+        case MATRIX_BACKEND_NATIVE: return "native";
+        case MATRIX_BACKEND_UBLAS: return "ublas";
+        case MATRIX_BACKEND_LAPACK: return "lapack";
+    }
+    return "?";
+}
+
+static void report(const char* op, int n, MatrixBackend backend, double seconds, double flops) {
+    std::printf("%-16s n=%-6d %-7s %10.4f s %8.2f GFLOP/s\n", op, n, backend_name(backend), seconds,
+                flops / seconds * 1e-9);
+}
+
+static void bench_size(int n, bool ublas_all) {
+    std::vector<MatrixBackend> backends = {MATRIX_BACKEND_NATIVE, MATRIX_BACKEND_UBLAS};
+    if (matrix_lapack_available()) backends.push_back(MATRIX_BACKEND_LAPACK);
+    const double dn = n;
+
+    // V - ковариация порядковых статистик (она же матрица разложения и обращения),
+    // регрессия ycum = μ + σ E по ожиданиям
+    std::vector<double> probs(n);
+    for (int i = 0; i < n; i++) probs[i] = double(i + 1) / (n + 1);
+    Vector er;
+    Matrix v;
+    ordern_matrix(n, probs, er, v);
+    Matrix gls_x(n, 2), gls_y(n, 1);
+    for (int i = 0; i < n; i++) {
+        gls_x(i, 0) = 1.0;
+        gls_x(i, 1) = er(i);
+        gls_y(i, 0) = 10.0 + 2.0 * er(i) + 0.01 * std::sin(7.0 * i);
+    }
+    Matrix l = v;
+    matrix_set_backend(MATRIX_BACKEND_NATIVE);
+    CholeskyDecompose(l);
+
+    // Операнды создаются внутри замеров: при n = 8000 каждая матрица - 512 МБ
+    for (MatrixBackend backend : backends) {
+        if (backend == MATRIX_BACKEND_UBLAS && n > BENCH_UBLAS_MAX && !ublas_all) continue;
+        matrix_set_backend(backend);
+        double t;
+
+        {
+            const Matrix a = filled_matrix(n, n, 0.0), b = filled_matrix(n, n, 1.0);
+            Matrix c;
+            t = best_seconds([] {}, [&] { c = MultiplyMatrix(a, b); });
+            report("MultiplyMatrix", n, backend, t, 2.0 * dn * dn * dn);
+        }
+        {
+            Matrix work;
+            t = best_seconds([&] { work = v; }, [&] { CholeskyDecompose(work); });
+            report("Cholesky", n, backend, t, dn * dn * dn / 3.0);
+        }
+        {
+            const Matrix rhs_n = filled_matrix(n, n, 2.0);
+            Matrix rhs;
+            t = best_seconds([&] { rhs = rhs_n; }, [&] { SolveLower(l, rhs); });
+            report("SolveLower k=n", n, backend, t, dn * dn * dn);
+
+            t = best_seconds([&] { rhs = rhs_n; }, [&] { SolveLowerTrans(l, rhs); });
+            report("SolveLowerT k=n", n, backend, t, dn * dn * dn);
+        }
+        {
+            const Matrix rhs_2 = filled_matrix(n, 2, 3.0);
+            Matrix rhs;
+            t = best_seconds([&] { rhs = rhs_2; }, [&] { SolveLower(l, rhs); });
+            report("SolveLower k=2", n, backend, t, 2.0 * dn * dn);
+        }
+
+        // Вне LAPACK обращение одно и то же (LU uBLAS) - замеряется один раз
+        if (backend == MATRIX_BACKEND_LAPACK || (backend == MATRIX_BACKEND_UBLAS && n <= BENCH_INVERSE_MAX)) {
+            Matrix inv;
+            t = best_seconds([] {}, [&] { inv = InverseMatrix(v); });
+            report("InverseMatrix", n, backend, t, 2.0 * dn * dn * dn);
+        }
+
+        // Разложение V и решения с X (k = 2) и y; GFLOP/s - по разложению
+        Matrix db, gls_b;
+        Vector yr;
+        t = best_seconds([] {}, [&] { MleastSquare_weight(gls_x, gls_y, v, db, gls_b, yr); });
+        report("GLS dense", n, backend, t, dn * dn * dn / 3.0);
+    }
+    matrix_set_backend(MATRIX_BACKEND_NATIVE);
+}
+
+int main(int argc, char** argv) {
+    bool ublas_all = false;
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--ublas-all") == 0) {
+            ublas_all = true;
+        } else if (std::atoi(argv[i]) > 0) {
+            sizes.push_back(std::atoi(argv[i]));
+        }
+    }
+    if (sizes.empty()) sizes = {500, 2000};
+    for (int n : sizes) bench_size(n, ublas_all);
+    return 0;
+}
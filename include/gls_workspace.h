@@ -0,0 +1,102 @@
+#ifndef GLS_WORKSPACE_H
+#define GLS_WORKSPACE_H
+
+#include <cstddef>
+#include <type_traits>
+
+// ========== Рабочая область взвешенного МНК ==========
+
+/**
+ * Арена для повторяющихся оценок взвешенным МНК (пакетная обработка партий).
+ * Один блок памяти, выровненный на 64 байта, нарезается на буферы
+ * (ковариация и ее множитель Холецкого, X, y и их "отбеленные" копии,
+ * производные квантильной функции, упорядоченная выборка).
+ * Буферы выдаются стеком: все, что взято внутри Scope, возвращается
+ * при его завершении. Если блока не хватило, недостающее выделяется
+ * отдельно, а при освобождении всех буферов блок расширяется до наибольшей
+ * потребности. Поэтому в установившемся режиме (объем выборки не растет)
+ * память не выделяется - это проверяется счетчиком allocations().
+ * MLS-оценки с рабочей областью (mls_normal_complete(data, ws) и др.) берут
+ * буферы из нее только при числе наблюдаемых порядковых статистик меньше
+ * MLS_STRUCTURED_MIN_N = 200: большие выборки решаются структурированной
+ * ковариацией с собственными буферами O(n), которые выделяются при каждой оценке.
+ * Один экземпляр используется одним потоком.
+ */
+class GlsWorkspace {
+public:
+    /**
+     * @param doubles - начальная емкость в double (см. mls_workspace_size)
+     */
+    explicit GlsWorkspace(size_t doubles = 0);
+    ~GlsWorkspace();
+
+    GlsWorkspace(const GlsWorkspace&) = delete;
+    GlsWorkspace& operator=(const GlsWorkspace&) = delete;
+
+    /**
+     * Область видимости буферов: при выходе из нее все буферы,
+     * взятые после ее создания, возвращаются в арену
+     */
+    class Scope {
+    public:
+        explicit Scope(GlsWorkspace& ws) : ws(ws), mark(ws.used), chunks(ws.overflow_count) {}
+        ~Scope() { ws.release(mark, chunks); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        GlsWorkspace& ws;
+        size_t mark;
+        size_t chunks;
+    };
+
+    /**
+     * Буфер из count элементов, выровненный на 64 байта, содержимое не инициализировано
+     */
+    double* take(size_t count);
+
+    /**
+     * Буфер из count объектов тривиального типа T
+     */
+    template <typename T>
+    T* take_as(size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= 64,
+                      "в арене размещаются только тривиальные типы");
+        return reinterpret_cast<T*>(take((count * sizeof(T) + sizeof(double) - 1) / sizeof(double)));
+    }
+
+    /**
+     * Емкость основного блока в double
+     */
+    size_t capacity() const { return cap; }
+
+    /**
+     * Отладочный счетчик: число выделений памяти за время жизни арены
+     * (основной блок и дополнительные куски). Не меняется между оценками,
+     * если их размер не превышает уже достигнутого.
+     */
+    size_t allocations() const { return allocs; }
+
+    /**
+     * Число double, занимаемое буфером из count элементов (с выравниванием)
+     */
+    static size_t slice(size_t count);
+
+private:
+    void release(size_t mark, size_t chunks);
+
+    double* base = nullptr;     // основной блок
+    size_t cap = 0;             // его емкость
+    size_t used = 0;            // занято буферами
+    size_t demand = 0;          // наибольшая потребность с учетом дополнительных кусков
+    size_t allocs = 0;
+
+    static const size_t MAX_OVERFLOW = 64;
+    double* overflow[MAX_OVERFLOW];     // дополнительные куски (стеком)
+    size_t overflow_size[MAX_OVERFLOW];
+    size_t overflow_count = 0;
+    size_t overflow_total = 0;
+};
+
+#endif // GLS_WORKSPACE_H
@@ -4,6 +4,7 @@
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/ublas/io.hpp>
+#include <boost/numeric/ublas/symmetric.hpp>
 
 namespace ublas = boost::numeric::ublas;
 
@@ -11,6 +12,42 @@ namespace ublas = boost::numeric::ublas;
 typedef ublas::matrix<double> Matrix;
 typedef ublas::vector<double> Vector;
 
+// Упакованная симметричная матрица: верхний треугольник по строкам, n(n+1)/2 элементов.
+// Строка i занимает элементы (i, i..n-1) подряд, начиная с packed_row_offset(n, i).
+typedef ublas::symmetric_matrix<double, ublas::upper, ublas::row_major> SymmetricMatrix;
+
+/**
+ * Смещение начала строки i (элемента (i, i)) в упакованном хранилище SymmetricMatrix
+ */
+inline size_t packed_row_offset(size_t n, size_t i) {
+    return i * n - i * (i - 1) / 2;
+}
+
+// Реализация умножения, разложения Холецкого и треугольных решений
+enum MatrixBackend {
+    MATRIX_BACKEND_NATIVE,  // блочные ядра (AVX2 при наличии), по умолчанию
+    MATRIX_BACKEND_UBLAS,   // Boost.uBLAS - эталонный путь
+    MATRIX_BACKEND_LAPACK   // установленные BLAS/LAPACK (сборка make USE_LAPACK=1), тогда по умолчанию
+};
+
+/**
+ * Выбор реализации плотных операций (MultiplyMatrix, CholeskyDecompose,
+ * SolveLower, SolveLowerTrans). Обращение матриц идет через uBLAS,
+ * кроме MATRIX_BACKEND_LAPACK (dgetrf/dgetri).
+ * Выбор LAPACK в сборке без него - исключение std::runtime_error.
+ */
+void matrix_set_backend(MatrixBackend backend);
+
+/**
+ * Собрана ли программа с BLAS/LAPACK
+ */
+bool matrix_lapack_available();
+
+/**
+ * Текущая реализация плотных операций
+ */
+MatrixBackend matrix_backend();
+
 /**
  * Создание матрицы заданного размера, инициализированной нулями
  * @param rows - количество строк
@@ -41,6 +78,108 @@ Matrix MultiplyMatrix(const Matrix& a, const Matrix& b);
  */
 Matrix InverseMatrix(const Matrix& a);
 
+/**
+ * Разложение Холецкого симметричной положительно определенной матрицы: A = L L^T.
+ * Выполняется на месте: нижний треугольник a заменяется на L, верхний обнуляется.
+ * @param a - исходная матрица (n x n), на выходе L
+ */
+void CholeskyDecompose(Matrix& a);
+
+/**
+ * Прямая подстановка L Z = B на месте (Z записывается в b)
+ * @param l - нижнетреугольный множитель Холецкого (n x n)
+ * @param b - правые части (n x k), на выходе решение
+ */
+void SolveLower(const Matrix& l, Matrix& b);
+
+/**
+ * Обратная подстановка L^T Z = B на месте (L^T не формируется)
+ * @param l - нижнетреугольный множитель Холецкого (n x n)
+ * @param b - правые части (n x k), на выходе решение
+ */
+void SolveLowerTrans(const Matrix& l, Matrix& b);
+
+// ========== Одинарная и смешанная точность ==========
+// Разложение во float: вдвое больше элементов в векторе и вдвое меньше
+// трафика памяти, но точность ~1e-7. Точность double восстанавливается
+// итерационным уточнением с невязками, вычисляемыми по исходной матрице в double.
+
+typedef ublas::matrix<float> MatrixFloat;
+
+/**
+ * Разложение Холецкого, прямая и обратная подстановки во float
+ * (те же реализации, что и для Matrix, см. matrix_set_backend)
+ */
+void CholeskyDecompose(MatrixFloat& a);
+void SolveLower(const MatrixFloat& l, MatrixFloat& b);
+void SolveLowerTrans(const MatrixFloat& l, MatrixFloat& b);
+
+/**
+ * Итог итерационного уточнения
+ */
+struct RefinementReport {
+    int steps = 0;          // шагов уточнения после первого решения во float
+    bool fallback = false;  // уточнение не сошлось, решение получено разложением в double
+    double residual = 0.0;  // max по столбцам ||B - V Z||_inf / (||V||_inf ||Z||_inf)
+};
+
+/**
+ * Решение V Z = B для симметричной положительно определенной V в смешанной точности:
+ * V раскладывается во float, затем решение уточняется шагами Z += V_f^{-1} (B - V Z),
+ * невязка считается в double. Критерий сходимости как в LAPACK dsposv:
+ * ||r||_inf <= sqrt(n) eps ||V||_inf ||z||_inf для каждого столбца.
+ * Если разложение во float невозможно, невязка перестает убывать (хотя бы вдвое
+ * за шаг) или сделано MIXED_REFINEMENT_MAX шагов, задача решается заново в double.
+ * @param v - матрица системы (n x n)
+ * @param b - правые части (n x k), на выходе решение
+ * @param report - число шагов уточнения и переход на double (output, может быть nullptr)
+ */
+void CholeskySolveMixed(const Matrix& v, Matrix& b, RefinementReport* report = nullptr);
+
+const int MIXED_REFINEMENT_MAX = 30;
+
+// ========== Операции с упакованными симметричными матрицами ==========
+// Работают непосредственно с упакованным хранилищем (половина памяти и трафика
+// по сравнению с Matrix). Из реализаций (matrix_set_backend) отдельная только
+// у LAPACK (dpptrf, dtpsv), остальные используют общие упакованные ядра.
+
+/**
+ * Произведение симметричной матрицы на матрицу (набор векторов) за один проход по a
+ * @param a - симметричная матрица (n x n)
+ * @param b - матрица (n x k)
+ * @return a * b (n x k)
+ */
+Matrix MultiplyMatrix(const SymmetricMatrix& a, const Matrix& b);
+
+/**
+ * Разложение Холецкого на месте: A = L L^T. Хранится верхний треугольник L^T,
+ * поэтому элемент (i, j), i >= j, результата - это L(i, j).
+ * Блочное правостороннее обновление: строки хвоста обновляются сразу
+ * блоком строк L^T, каждая строка хвоста читается один раз на блок.
+ * @param a - исходная матрица, на выходе множитель L
+ */
+void CholeskyDecompose(SymmetricMatrix& a);
+
+/**
+ * Прямая подстановка L Z = B на месте для множителя из CholeskyDecompose(SymmetricMatrix&)
+ */
+void SolveLower(const SymmetricMatrix& l, Matrix& b);
+
+/**
+ * Обратная подстановка L^T Z = B на месте для множителя из CholeskyDecompose(SymmetricMatrix&)
+ */
+void SolveLowerTrans(const SymmetricMatrix& l, Matrix& b);
+
+/**
+ * Те же разложение и решения для упакованного хранилища во внешнем буфере
+ * (например, из GlsWorkspace) - без выделения памяти
+ * @param a - n(n+1)/2 элементов в порядке SymmetricMatrix
+ * @param b - правые части (n x k) по строкам
+ */
+void CholeskyDecomposePacked(double* a, size_t n);
+void SolveLowerPacked(const double* l, size_t n, double* b, size_t k);
+void SolveLowerTransPacked(const double* l, size_t n, double* b, size_t k);
+
 /**
  * Вывод матрицы на экран
  * @param a - матрица для вывода
@@ -1,33 +1,54 @@
 #ifndef MLE_METHODS_H
 #define MLE_METHODS_H
 
+#include <array>
 #include <vector>
+#include "gls_workspace.h"
+#include "nelder_mead.h"
+#include "root_solver.h"
+#include "small_matrix.h"
 
 // Структура для хранения результатов MLE
+// (обычное значение: копируется и перемещается, память освобождается автоматически)
 struct MLEResult {
     std::vector<double> parameters;        // оценки параметров
     std::vector<double> initial_parameters; // начальные оценки параметров
-    double** covariance;                   // ковариационная матрица
+    CovarianceMatrix covariance;           // ковариационная матрица (covariance.size() параметров)
     std::vector<double> std_errors;        // стандартные ошибки
-    double log_likelihood;                 // логарифм функции правдоподобия
-    double initial_log_likelihood;         // начальное значение log-likelihood
-    int iterations;                        // число итераций
-    bool converged;                        // флаг сходимости
-    int cov_size;                          // размер ковариационной матрицы
+    double log_likelihood = 0.0;           // логарифм функции правдоподобия
+    double initial_log_likelihood = 0.0;   // начальное значение log-likelihood
+    int iterations = 0;                    // число итераций
+    bool converged = false;                // флаг сходимости
 };
 
-// Целевая функция для оптимизации (нормальное распределение)
-double NormalMinFunction(std::vector<double> xsimpl);
+// Целевая функция для оптимизации (нормальное распределение):
+// квадрат невязки уравнений правдоподобия по данным ctx, параметры (μ, σ)
+double NormalMinValue(const FitContext& ctx, const std::array<double, 2>& xsimpl);
+
+// Целевая функция для оптимизации (распределение Вейбулла), параметр формы
+double WeibullMinValue(const FitContext& ctx, const std::array<double, 1>& xsimpl);
 
-// Целевая функция для оптимизации (распределение Вейбулла)
+// Устаревшие формы с данными из глобальной nesm (не потокобезопасны)
+double NormalMinFunction(std::vector<double> xsimpl);
 double WeibullMinFunction(std::vector<double> xsimpl);
 
+// Параметр формы Вейбулла по MLE (данные ctx, правое цензурирование): корень
+// профильного уравнения правдоподобия (то же, что минимизирует WeibullMinValue)
+// методом Ньютона с защитой бисекцией, b0 - начальное приближение.
+// Производная - в том же проходе по данным; обычно 5-8 проходов до машинной точности
+RootResult weibull_shape_mle(const FitContext& ctx, double b0);
+
 // Вычисление ковариационной матрицы для нормального распределения
-void CovMatrixMleN(int n, std::vector<double> x, std::vector<int> r, 
+// (информационная матрица 2 x 2 и ее обращение в явном виде, без выделения памяти)
+Mat2 CovMatrixMleN(int n, const std::vector<double>& x, const std::vector<int>& r,
+                   double a, double s);
+void CovMatrixMleN(int n, const std::vector<double>& x, const std::vector<int>& r,
                    double a, double s, double**& v);
 
 // Вычисление ковариационной матрицы для распределения Вейбулла
-void CovMatrixMleW(int n, std::vector<double> x, std::vector<int> r, 
+Mat2 CovMatrixMleW(int n, const std::vector<double>& x, const std::vector<int>& r,
+                   double c, double b);
+void CovMatrixMleW(int n, const std::vector<double>& x, const std::vector<int>& r,
                    double c, double b, double**& v);
 
 // MLE для нормального распределения (полные данные)
@@ -36,9 +57,99 @@ MLEResult mle_normal_complete(const std::vector<double>& data);
 // MLE для распределения Вейбулла (полные данные)
 MLEResult mle_weibull_complete(const std::vector<double>& data);
 
+// ========== Выбор способа MLS по бюджету памяти ==========
+
+// Способ решения взвешенного МНК по порядковым статистикам
+enum MlsStrategy {
+    MLS_STRATEGY_TABLE,         // готовая таблица весов из кеша (полная выборка): O(n)
+    MLS_STRATEGY_DENSE,         // построение таблицы кеша с плотной V n x n и ее множителем: ~3 n²
+    MLS_STRATEGY_TILED,         // построение таблицы кеша блоками строк V прямо в файл: O(n)
+    MLS_STRATEGY_PACKED,        // упакованная V и разложение Холецкого в рабочей области: n²/2
+    MLS_STRATEGY_STRUCTURED     // полуразделимая V и сопряженные градиенты: O(n)
+};
+
+/**
+ * Какой способ выбран и сколько памяти он занял
+ */
+struct MlsMemoryReport {
+    MlsStrategy strategy = MLS_STRATEGY_PACKED;
+    size_t budget = 0;          // бюджет при выборе, байт (0 - без ограничения)
+    size_t estimated_peak = 0;  // оценка пика выбранного способа (mls_strategy_memory), байт
+    size_t measured_peak = 0;   // прирост пика резидентной памяти процесса за оценку, байт
+                                // (Linux, /proc/self/status VmHWM; 0 - замер недоступен)
+};
+
+/**
+ * Бюджет памяти MLS-оценки в байтах; 0 - без ограничения.
+ * По умолчанию - половина физической памяти (где ее можно узнать).
+ * Перед каждой оценкой пик памяти оценивается заранее, и из способов, которые
+ * укладываются в бюджет, выбирается самый быстрый:
+ *   полная выборка с кешем (AGAMIROV_ORDER_CACHE) - готовая таблица, иначе
+ *   ее построение плотным способом, иначе по частям (TILED);
+ *   иначе при n < 200 - упакованная V, иначе (и если она не помещается) - структурированная.
+ * Если не помещается и структурированная - исключение std::runtime_error
+ * до начала вычислений (вместо завершения процесса системой при нехватке памяти).
+ */
+void mls_set_memory_budget(size_t bytes);
+
+/**
+ * Текущий бюджет памяти MLS, байт (0 - без ограничения)
+ */
+size_t mls_memory_budget();
+
+/**
+ * Оценка пиковой памяти (байт) способа strategy для m порядковых статистик
+ */
+size_t mls_strategy_memory(MlsStrategy strategy, size_t m);
+
+/**
+ * Название способа ("table", "dense", "tiled", "packed", "structured")
+ */
+const char* mls_strategy_name(MlsStrategy strategy);
+
+// MLE для нормального распределения с правым цензурированием: метод Ньютона
+// с доверительной областью (newton_trust_region) по аналитическим градиенту и гессиану
+// -log L. Сходится за несколько проходов по данным; ковариация - обращение
+// наблюдаемой информации (гессиана -log L) в точке оценки
+MLEResult mle_normal_censored(const std::vector<double>& data, const std::vector<int>& censored);
+
 // MLS для нормального распределения (ТОЛЬКО полные данные, через метод Дэйвида - ordern)
 MLEResult mls_normal_complete(const std::vector<double>& data);
 
+// То же с рабочей областью ws, общей для серии оценок: буферы взвешенного МНК
+// берутся из нее, и при n <= уже достигнутого память под них не выделяется.
+// Это верно для n < MLS_STRUCTURED_MIN_N (200), как и для остальных перегрузок
+// с ws ниже (там - по числу отказов km): для больших выборок структурированный
+// путь выделяет свои буферы O(n) при каждом вызове, ws не используется.
+// memory (может быть nullptr) - выбранный по бюджету способ и замеренный пик памяти
+MLEResult mls_normal_complete(const std::vector<double>& data, GlsWorkspace& ws,
+                              MlsMemoryReport* memory = nullptr);
+
+// MLS для распределения Вейбулла (полные данные, взвешенный МНК по порядковым статистикам orderw)
+MLEResult mls_weibull_complete(const std::vector<double>& data);
+MLEResult mls_weibull_complete(const std::vector<double>& data, GlsWorkspace& ws);
+
+// MLS для нормального распределения (цензура II типа и прогрессивная, система km x km по отказам)
+MLEResult mls_normal_progressive(const std::vector<double>& data, const std::vector<int>& censored);
+MLEResult mls_normal_progressive(const std::vector<double>& data, const std::vector<int>& censored,
+                                 GlsWorkspace& ws);
+
+// MLS для распределения Вейбулла (цензура II типа и прогрессивная, система km x km по отказам)
+MLEResult mls_weibull_progressive(const std::vector<double>& data, const std::vector<int>& censored);
+MLEResult mls_weibull_progressive(const std::vector<double>& data, const std::vector<int>& censored,
+                                  GlsWorkspace& ws);
+
+// Совместный MLS для нормального распределения по k подвыборкам с общей σ и своими μ_j.
+// data и censored - подвыборки подряд, nsample - их размеры (как ne_simp::nsample).
+// Параметры: μ_1..μ_k, σ
+MLEResult mls_normal_multisample(const std::vector<double>& data, const std::vector<int>& censored,
+                                 const std::vector<int>& nsample);
+
+// Совместный MLS для распределения Вейбулла по k подвыборкам с общей формой k и своими λ_j.
+// Параметры: λ_1..λ_k, k
+MLEResult mls_weibull_multisample(const std::vector<double>& data, const std::vector<int>& censored,
+                                  const std::vector<int>& nsample);
+
 // Вывод результатов MLE
 void print_mle_result(const MLEResult& result, const char* method_name);
 
@@ -47,7 +158,8 @@ void save_mle_result(const MLEResult& result, const char* filename,
                      const std::vector<double>& data,
                      const std::vector<int>& censored);
 
-// Освобождение памяти результата
+// Сброс результата. Ковариация принадлежит MLEResult и освобождается сама,
+// вызов оставлен для совместимости со старым кодом
 void free_mle_result(MLEResult& result);
 
 #endif // MLE_METHODS_H
\ No newline at end of file
@@ -1,6 +1,10 @@
 #ifndef NELDER_MEAD_H
 #define NELDER_MEAD_H
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <vector>
 #include <functional>
 
@@ -13,15 +17,130 @@ struct ne_simp {
     std::vector<int> nsample;       // размеры подвыборок
 };
 
+// Счетчики работы метода Нелдера-Мида
+struct NelderMeadCounters {
+    int evaluations = 0;    // вызовов целевой функции (включая начальный симплекс)
+    int reflections = 0;    // принятых отражений
+    int expansions = 0;     // принятых расширений
+    int contractions = 0;   // принятых сжатий (внешних и внутренних)
+    int shrinks = 0;        // уменьшений всего симплекса к лучшей вершине
+};
+
 // Структура для результата оптимизации Nelder-Mead
 struct NelderMeadResult {
     std::vector<double> parameters; // оптимальные параметры
     int iterations;                 // количество итераций
     bool converged;                 // флаг сходимости
     double final_value;            // финальное значение целевой функции
+    NelderMeadCounters counters;    // вызовы функции и шаги по типам
+};
+
+// ========== Наблюдение за итерациями ==========
+
+// Шаг, которым закончилась итерация
+enum NelderMeadStep {
+    NELDER_MEAD_REFLECT,            // отражение
+    NELDER_MEAD_EXPAND,             // расширение
+    NELDER_MEAD_CONTRACT_OUTSIDE,   // внешнее сжатие
+    NELDER_MEAD_CONTRACT_INSIDE,    // внутреннее сжатие
+    NELDER_MEAD_SHRINK              // уменьшение к лучшей вершине
+};
+
+// Запись об одной итерации
+struct NelderMeadIteration {
+    int iteration = 0;              // номер итерации (с 1)
+    NelderMeadStep step = NELDER_MEAD_REFLECT;
+    double best = 0.0;              // значение функции в лучшей вершине после шага
+    double worst = 0.0;             // в наихудшей вершине после шага
+    double size = 0.0;              // размер симплекса перед шагом (критерий остановки)
+    int evaluations = 0;            // вызовов функции с начала оптимизации
+    double seconds = 0.0;           // время с начала оптимизации
+    const double* point = nullptr;  // лучшая вершина (n координат), действительна только во время вызова
+};
+
+/**
+ * Наблюдатель итераций: вызывается после каждого шага метода.
+ * Время (seconds) измеряется только при подключенном наблюдателе.
+ */
+class NelderMeadObserver {
+public:
+    virtual ~NelderMeadObserver() = default;
+    virtual void on_iteration(const NelderMeadIteration& it) = 0;
+
+    /**
+     * Прервать оптимизацию после текущей итерации (проверяется после on_iteration).
+     * Результат тогда - лучшая вершина, converged = false
+     */
+    virtual bool stop_requested() const { return false; }
 };
 
-// Глобальная переменная для передачи данных в функцию оптимизации
+/**
+ * Трасса последних capacity итераций в кольцевом буфере, выделенном заранее:
+ * запись итерации не выделяет память, старые записи вытесняются.
+ * Один экземпляр - одна оптимизация в одном потоке (между запусками - clear()).
+ */
+class NelderMeadTrace : public NelderMeadObserver {
+public:
+    explicit NelderMeadTrace(size_t capacity);
+
+    void on_iteration(const NelderMeadIteration& it) override;
+
+    size_t capacity() const { return ring.size(); }
+    size_t size() const { return count; }           // сохранено записей
+    size_t dropped() const { return total - count; } // вытеснено старых
+
+    /**
+     * Запись i по времени: 0 - самая старая из сохраненных
+     */
+    const NelderMeadIteration& operator[](size_t i) const;
+
+    void clear();
+
+private:
+    std::vector<NelderMeadIteration> ring;
+    size_t head = 0;    // позиция следующей записи
+    size_t count = 0;
+    size_t total = 0;
+};
+
+/**
+ * Параметры остановки и наблюдения
+ */
+struct NelderMeadOptions {
+    double eps = 1e-6;                      // точность (размер симплекса по каждой координате)
+    int max_iter = 1000;                    // максимальное число итераций
+    NelderMeadObserver* observer = nullptr; // наблюдатель итераций (может быть nullptr)
+};
+
+/**
+ * Данные целевой функции: выборка и индикаторы цензурирования (0 - наблюдение,
+ * 1 - цензура). Только ссылается на массивы вызывающего, поэтому копируется
+ * даром и передается оптимизатору вместе с целевой функцией. Каждая подгонка
+ * держит свой контекст, и подгонки по разным данным выполняются параллельно.
+ */
+struct FitContext {
+    const double* x = nullptr;  // данные (n)
+    const int* r = nullptr;     // индикаторы цензурирования (n), nullptr - полная выборка
+    int n = 0;                  // размер выборки
+
+    FitContext() = default;
+    FitContext(const double* x, const int* r, int n) : x(x), r(r), n(n) {}
+
+    /**
+     * @param r - индикаторы того же размера, что x, или пустой вектор (полная выборка)
+     */
+    FitContext(const std::vector<double>& x, const std::vector<int>& r)
+        : x(x.data()), r(r.empty() ? nullptr : r.data()), n(int(x.size())) {}
+
+    explicit FitContext(const ne_simp& data) : FitContext(data.x, data.r) {}
+
+    // Индикатор цензурирования i-го наблюдения
+    int censored(int i) const { return r != nullptr ? r[i] : 0; }
+};
+
+// Устаревшая глобальная переменная для целевых функций с одним параметром
+// std::vector<double> (NormalMinFunction, WeibullMinFunction). Не потокобезопасна;
+// новый код передает FitContext
 extern ne_simp nesm;
 
 // Функция оптимизации методом Nelder-Mead
@@ -39,4 +158,317 @@ NelderMeadResult neldermead_detailed(
     std::function<double(std::vector<double>)> func      // целевая функция
 );
 
+// То же с явным контекстом: func(ctx, x) вызывается с данными подгонки
+NelderMeadResult neldermead_detailed(
+    std::vector<double>& x0,                              // начальная точка
+    double eps,                                           // точность
+    const FitContext& ctx,                                // данные целевой функции
+    std::function<double(const FitContext&, const std::vector<double>&)> func
+);
+
+// То же с параметрами остановки и наблюдателем итераций
+NelderMeadResult neldermead_detailed(
+    std::vector<double>& x0,                              // начальная точка
+    const NelderMeadOptions& options,                     // точность, число итераций, наблюдатель
+    std::function<double(std::vector<double>)> func      // целевая функция
+);
+
+NelderMeadResult neldermead_detailed(
+    std::vector<double>& x0,
+    const NelderMeadOptions& options,
+    const FitContext& ctx,
+    std::function<double(const FitContext&, const std::vector<double>&)> func
+);
+
+// ========== Мультистарт ==========
+
+/**
+ * Параметры мультистарта
+ */
+struct MultiStartOptions {
+    int starts = 16;            // число запусков K (включая x0)
+    NelderMeadOptions local;    // точность и число итераций каждого запуска (observer не используется)
+    int abandon_after = 10;     // итераций до первой проверки на доминирование
+    double abandon_gap = 1.0;   // запуск прерывается, если его лучшее значение больше общего
+                                // лучшего на abandon_gap * max(1, |лучшее|)
+    double merge_radius = 0.05; // или если его лучшая вершина ближе merge_radius (доля стороны
+                                // области по каждой координате) к лучшей найденной точке,
+                                // а значение хуже: запуск сходится к уже найденному минимуму
+};
+
+/**
+ * Результат мультистарта
+ */
+struct MultiStartResult {
+    NelderMeadResult best;      // лучший из завершенных запусков
+    int best_start = -1;        // его номер (0 - x0, далее - точки плана)
+    int starts = 0;             // запусков
+    int converged = 0;          // из них сошлось
+    int abandoned = 0;          // прервано как заведомо худшие
+    int evaluations = 0;        // вызовов функции всего (с оценкой точек плана)
+};
+
+/**
+ * Nelder-Mead из K начальных точек: x0 и K - 1 точек последовательности Холтона
+ * в параллелепипеде [lower, upper]. Сначала функция вычисляется во всех точках,
+ * и запуски выполняются в общем пуле потоков от лучших точек к худшим. Запуски
+ * делят лучшую найденную точку и прерываются, если после abandon_after итераций
+ * заведомо хуже нее или попали в ее окрестность (merge_radius) с худшим значением,
+ * поэтому надежность стоит немногим больше одной подгонки. func вызывается одновременно из нескольких потоков
+ * (данные - через FitContext, а не глобальные переменные).
+ * В одном потоке результат детерминирован; в нескольких от порядка выполнения
+ * может зависеть только то, какие из худших запусков прерваны.
+ * Исключение из func (в любом потоке) прекращает мультистарт: оставшиеся
+ * запуски не начинаются, и после завершения начатых первое исключение
+ * передается вызывающему - так же, как при одном потоке.
+ * @param x0 - начальная точка (запуск 0)
+ * @param lower, upper - границы области для плана (размерность x0)
+ * @param options - число запусков, параметры каждого и прерывания
+ * @param func - целевая функция
+ */
+MultiStartResult neldermead_multistart(
+    const std::vector<double>& x0,
+    const std::vector<double>& lower,
+    const std::vector<double>& upper,
+    const MultiStartOptions& options,
+    std::function<double(std::vector<double>)> func
+);
+
+MultiStartResult neldermead_multistart(
+    const std::vector<double>& x0,
+    const std::vector<double>& lower,
+    const std::vector<double>& upper,
+    const MultiStartOptions& options,
+    const FitContext& ctx,
+    std::function<double(const FitContext&, const std::vector<double>&)> func
+);
+
+// ========== Общее ядро метода ==========
+
+/**
+ * Итерации Нелдера-Мида для вершин типа Point (std::vector<double> или
+ * std::array<double, N>) в симплексе simplex (n + 1 вершин, все равны x0
+ * при вызове). centroid, reflected, trial - рабочие точки той же размерности.
+ * Вершины упорядочиваются на месте вставками (устойчиво), поэтому ядро само
+ * не выделяет память. На выходе simplex[0] и f_values[0] - лучшая вершина
+ * после последнего упорядочения (при исчерпании max_iter вершины последнего
+ * шага не упорядочиваются, как и в прежних реализациях).
+ * Общее для neldermead, neldermead_detailed и neldermead<N>.
+ */
+template <typename Simplex, typename Values, typename Point, typename F>
+void neldermead_core(Simplex& simplex, Values& f_values, Point& centroid, Point& reflected, Point& trial,
+                     const NelderMeadOptions& options, F&& func,
+                     int& iterations, bool& converged, NelderMeadCounters& counters) {
+    const double alpha = 1.0;    // коэффициент отражения
+    const double gamma = 2.0;    // коэффициент расширения
+    const double rho = 0.5;      // коэффициент сжатия
+    const double sigma = 0.5;    // коэффициент уменьшения
+
+    typedef std::chrono::steady_clock Clock;
+    NelderMeadObserver* observer = options.observer;
+    Clock::time_point start = (observer != nullptr) ? Clock::now() : Clock::time_point();
+    const size_t n = simplex[0].size();
+
+    auto evaluate = [&](const Point& p) {
+        counters.evaluations++;
+        return func(p);
+    };
+
+    // Упорядочение вершин вставками на месте (устойчивое, как std::sort для коротких массивов)
+    auto order = [&]() {
+        for (size_t i = 1; i <= n; ++i) {
+            for (size_t j = i; j > 0 && f_values[j] < f_values[j - 1]; --j) {
+                std::swap(f_values[j], f_values[j - 1]);
+                std::swap(simplex[j], simplex[j - 1]);
+            }
+        }
+    };
+
+    // Инициализация симплекса
+    for (size_t i = 0; i <= n; ++i) {
+        if (i > 0) simplex[i][i - 1] += 0.1 * (simplex[0][i - 1] != 0.0 ? simplex[0][i - 1] : 1.0);
+        f_values[i] = evaluate(simplex[i]);
+    }
+
+    iterations = 0;
+    converged = false;
+    for (int iter = 0; iter < options.max_iter; ++iter) {
+        iterations = iter + 1;
+
+        order();
+
+        // Проверка сходимости: размах симплекса по каждой координате
+        double size = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            double lo = simplex[0][j], hi = simplex[0][j];
+            for (size_t i = 1; i <= n; ++i) {
+                lo = std::min(lo, simplex[i][j]);
+                hi = std::max(hi, simplex[i][j]);
+            }
+            size = std::max(size, hi - lo);
+        }
+        if (size < options.eps) {
+            converged = true;
+            return;
+        }
+
+        // Центроид без наихудшей вершины
+        for (size_t j = 0; j < n; ++j) {
+            double c = 0.0;
+            for (size_t i = 0; i < n; ++i) c += simplex[i][j];
+            centroid[j] = c / n;
+        }
+
+        // Отражение
+        for (size_t j = 0; j < n; ++j) reflected[j] = centroid[j] + alpha * (centroid[j] - simplex[n][j]);
+        double f_reflected = evaluate(reflected);
+
+        NelderMeadStep step = NELDER_MEAD_REFLECT;
+        if (f_reflected < f_values[0]) {
+            // Расширение
+            for (size_t j = 0; j < n; ++j) trial[j] = centroid[j] + gamma * (reflected[j] - centroid[j]);
+            double f_expanded = evaluate(trial);
+            if (f_expanded < f_reflected) {
+                simplex[n] = trial;
+                f_values[n] = f_expanded;
+                step = NELDER_MEAD_EXPAND;
+            } else {
+                simplex[n] = reflected;
+                f_values[n] = f_reflected;
+            }
+        } else if (f_reflected < f_values[n - 1]) {
+            simplex[n] = reflected;
+            f_values[n] = f_reflected;
+        } else if (f_reflected < f_values[n]) {
+            // Внешнее сжатие
+            for (size_t j = 0; j < n; ++j) trial[j] = centroid[j] + rho * (reflected[j] - centroid[j]);
+            double f_contracted = evaluate(trial);
+            if (f_contracted < f_reflected) {
+                simplex[n] = trial;
+                f_values[n] = f_contracted;
+                step = NELDER_MEAD_CONTRACT_OUTSIDE;
+            } else {
+                step = NELDER_MEAD_SHRINK;
+            }
+        } else {
+            // Внутреннее сжатие
+            for (size_t j = 0; j < n; ++j) trial[j] = centroid[j] + rho * (simplex[n][j] - centroid[j]);
+            double f_contracted = evaluate(trial);
+            if (f_contracted < f_values[n]) {
+                simplex[n] = trial;
+                f_values[n] = f_contracted;
+                step = NELDER_MEAD_CONTRACT_INSIDE;
+            } else {
+                step = NELDER_MEAD_SHRINK;
+            }
+        }
+
+        switch (step) {
+            case NELDER_MEAD_REFLECT: counters.reflections++; break;
+            case NELDER_MEAD_EXPAND: counters.expansions++; break;
+            case NELDER_MEAD_CONTRACT_OUTSIDE:
+            case NELDER_MEAD_CONTRACT_INSIDE: counters.contractions++; break;
+            case NELDER_MEAD_SHRINK:
+                // Уменьшение к лучшей вершине
+                counters.shrinks++;
+                for (size_t i = 1; i <= n; ++i) {
+                    for (size_t j = 0; j < n; ++j) {
+                        simplex[i][j] = simplex[0][j] + sigma * (simplex[i][j] - simplex[0][j]);
+                    }
+                    f_values[i] = evaluate(simplex[i]);
+                }
+                break;
+        }
+
+        if (observer != nullptr) {
+            NelderMeadIteration it;
+            it.iteration = iterations;
+            it.step = step;
+            size_t best = 0;
+            it.worst = f_values[0];
+            for (size_t i = 1; i <= n; ++i) {
+                if (f_values[i] < f_values[best]) best = i;
+                it.worst = std::max(it.worst, f_values[i]);
+            }
+            it.best = f_values[best];
+            it.point = &simplex[best][0];
+            it.size = size;
+            it.evaluations = counters.evaluations;
+            it.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            observer->on_iteration(it);
+            if (observer->stop_requested()) {
+                order();
+                return;
+            }
+        }
+    }
+}
+
+// ========== Nelder-Mead фиксированной размерности ==========
+
+/**
+ * Результат neldermead<N>: параметры в std::array, без выделения памяти
+ */
+template <size_t N>
+struct NelderMeadFixedResult {
+    std::array<double, N> parameters{};    // оптимальные параметры
+    int iterations = 0;                     // количество итераций
+    bool converged = false;                 // флаг сходимости
+    double final_value = 0.0;               // финальное значение целевой функции
+    NelderMeadCounters counters;            // вызовы функции и шаги по типам
+};
+
+/**
+ * Метод Нелдера-Мида для N параметров (те же коэффициенты, начальный симплекс
+ * и критерий остановки, что у neldermead_detailed). Вершины - std::array
+ * в автоматической памяти, упорядочение на месте, целевая функция - шаблонный
+ * параметр, получающий вершину по ссылке без копирования:
+ *   double func(const std::array<double, N>& x).
+ * Ни одна итерация не выделяет память в куче (если ее не выделяет func),
+ * поэтому одно- и двухпараметрические подгонки (форма Вейбулла, μ/σ) не тратят
+ * время на аллокатор.
+ * @param x0 - начальная точка
+ * @param options - точность, число итераций, наблюдатель (или eps - только точность)
+ * @param func - целевая функция
+ */
+template <size_t N, typename F>
+NelderMeadFixedResult<N> neldermead(const std::array<double, N>& x0, const NelderMeadOptions& options, F&& func) {
+    static_assert(N > 0, "нужен хотя бы один параметр");
+    typedef std::array<double, N> Point;
+
+    NelderMeadFixedResult<N> result;
+    std::array<Point, N + 1> simplex;
+    std::array<double, N + 1> f_values;
+    simplex.fill(x0);
+
+    Point centroid, reflected, trial;
+    neldermead_core(simplex, f_values, centroid, reflected, trial, options, func,
+                    result.iterations, result.converged, result.counters);
+    result.parameters = simplex[0];
+    result.final_value = f_values[0];
+    return result;
+}
+
+template <size_t N, typename F>
+NelderMeadFixedResult<N> neldermead(const std::array<double, N>& x0, double eps, F&& func) {
+    NelderMeadOptions options;
+    options.eps = eps;
+    return neldermead(x0, options, func);
+}
+
+/**
+ * neldermead<N> с явным контекстом: func(ctx, x), ctx передается по ссылке
+ * в каждый вызов без копирования
+ */
+template <size_t N, typename Context, typename F>
+NelderMeadFixedResult<N> neldermead(const std::array<double, N>& x0, const NelderMeadOptions& options,
+                                    const Context& ctx, F&& func) {
+    return neldermead(x0, options, [&ctx, &func](const std::array<double, N>& x) { return func(ctx, x); });
+}
+
+template <size_t N, typename Context, typename F>
+NelderMeadFixedResult<N> neldermead(const std::array<double, N>& x0, double eps, const Context& ctx, F&& func) {
+    return neldermead(x0, eps, [&ctx, &func](const std::array<double, N>& x) { return func(ctx, x); });
+}
+
 #endif // NELDER_MEAD_H
\ No newline at end of file
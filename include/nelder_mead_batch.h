@@ -0,0 +1,88 @@
+#ifndef NELDER_MEAD_BATCH_H
+#define NELDER_MEAD_BATCH_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "nelder_mead.h"
+
+// ========== Пакетная подгонка многих малых выборок ==========
+
+// Модель: минимизируется -log L по полным и цензурированным справа наблюдениям
+enum BatchModel {
+    BATCH_MODEL_NORMAL,     // параметры (μ, σ)
+    BATCH_MODEL_WEIBULL     // параметры (λ, k) - масштаб и форма, как в MLEResult
+};
+
+// Дорожек в векторе: задач, вычисляемых одной векторной операцией
+const size_t NELDER_MEAD_BATCH_LANES = 8;
+
+// Ядро целевой функции. Все ядра дают побитово одинаковые значения:
+// модуль собирается без слияния умножения и сложения в FMA
+enum BatchKernel {
+    BATCH_KERNEL_AUTO,      // лучшее из доступных на процессоре
+    BATCH_KERNEL_GENERIC,   // базовый набор команд
+    BATCH_KERNEL_AVX2,      // AVX2 + FMA
+    BATCH_KERNEL_AVX512     // AVX-512F
+};
+
+/**
+ * Выбор ядра для neldermead_batch и neldermead_batch_value.
+ * Недоступный на процессоре набор инструкций заменяется следующим по ширине.
+ */
+void neldermead_batch_set_kernel(BatchKernel kernel);
+
+/**
+ * Ядро, которое фактически будет использовано
+ */
+BatchKernel neldermead_batch_active_kernel();
+
+/**
+ * Статистика пакетной подгонки
+ */
+struct NelderMeadBatchReport {
+    const char* kernel = "";            // ядро целевой функции: "avx512", "avx2" или "generic"
+    long long vector_evaluations = 0;   // вычислений функции сразу на всех дорожках
+    long long lane_evaluations = 0;     // из них на дорожках, занятых задачами
+};
+
+/**
+ * Nelder-Mead (те же шаги, что у neldermead<2>) для многих выборок сразу.
+ * NELDER_MEAD_BATCH_LANES задач хранятся по дорожкам в виде структуры массивов
+ * (наблюдение i всех задач подряд), и на каждом шаге каждая задача запрашивает
+ * одну точку: все точки вычисляются одним проходом векторного ядра (AVX-512,
+ * AVX2 или обычный код - по процессору, см. neldermead_batch_set_kernel). Сошедшаяся задача освобождает дорожку,
+ * и на нее сразу загружается следующая выборка; пустые дорожки маскируются.
+ * Поэтому 8 подгонок стоят примерно как одна. Части пакета обрабатываются
+ * параллельно в общем пуле потоков; результат задачи не зависит ни от соседей
+ * по дорожкам, ни от числа потоков, ни от ядра: он побитово совпадает с
+ * neldermead<2> на функции neldermead_batch_value.
+ * Для нормальной модели цензурированные наблюдения (log Q(z)) считаются
+ * скалярно, для Вейбулла все наблюдения - векторно. Вне области параметров
+ * (σ, λ, k <= 0) функция равна +inf.
+ * @param model - модель
+ * @param lots - выборки (для Вейбулла наблюдения положительны)
+ * @param x0 - начальные точки, по одной на выборку
+ * @param options - точность и число итераций (observer не используется)
+ * @param report - статистика (может быть nullptr)
+ * @return результаты в порядке lots; final_value = -log L
+ */
+std::vector<NelderMeadFixedResult<2>> neldermead_batch(
+    BatchModel model,
+    const std::vector<FitContext>& lots,
+    const std::vector<std::array<double, 2>>& x0,
+    const NelderMeadOptions& options,
+    NelderMeadBatchReport* report = nullptr
+);
+
+/**
+ * Целевая функция пакетной подгонки для одной выборки: -log L, вычисленный тем же
+ * кодом и ядром, что и в neldermead_batch (эталон для проверки пакетного пути)
+ * @param model - модель
+ * @param ctx - выборка
+ * @param x - параметры: (μ, σ) или (λ, k)
+ * @return -log L; +inf вне области параметров
+ */
+double neldermead_batch_value(BatchModel model, const FitContext& ctx, const std::array<double, 2>& x);
+
+#endif // NELDER_MEAD_BATCH_H
@@ -1,11 +1,35 @@
 #ifndef ORDER_H
 #define ORDER_H
 
+#include <functional>
 #include <vector>
 #include "matrix_operations.h"
+#include "gls_workspace.h"
+
+// Семейство распределений порядковых статистик
+enum OrderFamily {
+    ORDER_NORMAL = 0,   // ordern
+    ORDER_WEIBULL = 1   // orderw (логарифмическая шкала)
+};
 
 // ========== Агамировские функции для порядковых статистик ==========
 
+// Наибольший порядок разложения Дэйвида-Джонсона: члены до (n+2)^{-3}
+const int ORDER_EXPANSION_MAX = 3;
+
+/**
+ * Порядок усечения разложения для ordern/orderw, пакетных и структурированных
+ * функций: учитываются члены до (n+2)^{-order}, order = 1..ORDER_EXPANSION_MAX.
+ * Для больших n младшие порядки достаточно точны и не требуют старших
+ * производных квантильной функции. По умолчанию - ORDER_EXPANSION_MAX.
+ */
+void order_set_expansion(int order);
+
+/**
+ * Текущий порядок усечения разложения
+ */
+int order_expansion();
+
 /**
  * Вычисление математического ожидания и ковариации порядковых статистик
  * для нормального распределения
@@ -22,29 +46,265 @@ void ordern(int n, double pr, double ps, double& er, double& vrs);
  */
 void orderw(int n, double pr, double ps, double &er, double &vrs);
 
+// ========== Пакетное вычисление моментов порядковых статистик ==========
+
+/**
+ * Квантиль и производные обратной функции распределения в точке p,
+ * из которых строится разложение Дэйвида-Джонсона.
+ * Зависят только от p, поэтому вычисляются один раз на индекс.
+ */
+struct OrderTerms {
+    double p, q;                        // вероятность и 1 - p
+    double x;                           // квантиль x(p)
+    double x1, x2, x3, x4, x5, x6;      // производные x(p) 1-6 порядков
+};
+
+/**
+ * Производные квантильной функции нормального распределения
+ * @param order - порядок разложения: вычисляются производные до 2*order,
+ *                остальные равны нулю
+ */
+OrderTerms order_terms_normal(double p, int order = ORDER_EXPANSION_MAX);
+
+/**
+ * Производные квантильной функции распределения Вейбулла (логарифмическая шкала)
+ */
+OrderTerms order_terms_weibull(double p, int order = ORDER_EXPANSION_MAX);
+
+/**
+ * Математическое ожидание порядковой статистики по кешированным производным
+ * @param order - порядок усечения (0 - только квантиль x(p))
+ */
+double order_expectation(int n, const OrderTerms& r, int order = ORDER_EXPANSION_MAX);
+
+/**
+ * Ковариация r-ой и s-ой порядковых статистик (r <= s) по кешированным производным
+ */
+double order_covariance(int n, const OrderTerms& r, const OrderTerms& s, int order = ORDER_EXPANSION_MAX);
+
+/**
+ * Оценка погрешности усечения разложения порядка order для одного индекса:
+ * наибольший по модулю из последних учтенных членов ожидания и дисперсии.
+ * Для порядков 1 и 2 отброшенный остаток не превышает этой величины.
+ */
+double order_truncation_error(int n, const OrderTerms& t, int order);
+
+// Ядро вычисления строк ковариационной матрицы
+enum OrderKernel {
+    ORDER_KERNEL_AUTO,      // лучшее из доступных на процессоре
+    ORDER_KERNEL_SCALAR,    // скалярный эталонный путь
+    ORDER_KERNEL_AVX2,      // 4 столбца за шаг
+    ORDER_KERNEL_AVX512     // 8 столбцов за шаг
+};
+
+/**
+ * Выбор ядра для ordern_matrix/orderw_matrix.
+ * Недоступный на процессоре набор инструкций заменяется следующим по ширине.
+ */
+void order_set_kernel(OrderKernel kernel);
+
+/**
+ * Ядро, которое фактически будет использовано
+ */
+OrderKernel order_active_kernel();
+
+/**
+ * Вектор математических ожиданий и ковариационная матрица порядковых статистик
+ * нормального распределения для всей выборки.
+ * Квантили и производные вычисляются один раз на индекс (O(m) обращений к Boost),
+ * после чего матрица заполняется чистой арифметикой.
+ * @param n - размер выборки
+ * @param probs - вероятности порядковых статистик (по возрастанию), m = probs.size()
+ * @param er - математические ожидания (output, m)
+ * @param v - ковариационная матрица (output, m x m)
+ * @param error_bound - оценка погрешности усечения разложения текущего порядка
+ *                      (output, максимум order_truncation_error по индексам), если не nullptr
+ */
+void ordern_matrix(int n, const std::vector<double>& probs, Vector& er, Matrix& v,
+                   double* error_bound = nullptr);
+
+/**
+ * То же для распределения Вейбулла (в логарифмической шкале)
+ */
+void orderw_matrix(int n, const std::vector<double>& probs, Vector& er, Matrix& v,
+                   double* error_bound = nullptr);
+
+/**
+ * То же с упакованной симметричной матрицей: каждый элемент вычисляется
+ * и хранится один раз, память - m(m+1)/2 вместо m²
+ */
+void ordern_matrix(int n, const std::vector<double>& probs, Vector& er, SymmetricMatrix& v,
+                   double* error_bound = nullptr);
+
+void orderw_matrix(int n, const std::vector<double>& probs, Vector& er, SymmetricMatrix& v,
+                   double* error_bound = nullptr);
+
+/**
+ * Ковариационная матрица блоками строк без хранения m x m (для больших m, когда
+ * матрица нужна целиком, но в память не помещается - например, для записи в файл).
+ * Для каждого блока [i0, i1) вызывается sink(i0, i1, rows), rows - полные строки
+ * (i1 - i0) x m подряд; буфер действителен только во время вызова.
+ * Элементы побитово совпадают с ordern_matrix/orderw_matrix. Память - 2 * rows_per_tile * m
+ * и O(m) для производных.
+ * @param er - математические ожидания (output, m)
+ */
+void order_matrix_tiled(OrderFamily family, int n, const std::vector<double>& probs, size_t rows_per_tile,
+                        Vector& er, const std::function<void(size_t, size_t, const double*)>& sink);
+
+// ========== Структурированная ковариация порядковых статистик ==========
+
+/**
+ * Полуразделимое (semiseparable) представление ковариационной матрицы
+ * порядковых статистик: каждое слагаемое разложения Дэйвида-Джонсона
+ * при r <= s распадается в произведение A(r) * B(s), поэтому
+ *   V(r, s) = sum_k a[k][r] * b[k][s],  r <= s.
+ * Главный член p_r q_s x'_r x'_s / (n+2) имеет трехдиагональную обратную
+ * матрицу и служит предобуславливателем. Память - O(m), без матрицы m x m.
+ */
+struct OrderCovariance {
+    int n;                          // размер выборки
+    size_t m;                       // число порядковых статистик
+    std::vector<double> p, x1;      // вероятности и первые производные (для предобуславливателя)
+    std::vector<double> a, b;       // генераторы: a[k * m + r], b[k * m + s]
+    int order;                      // порядок усечения разложения
+    double error_bound;             // оценка погрешности усечения (см. order_truncation_error)
+};
+
+// Число пар генераторов в OrderCovariance
+const int ORDER_GENERATORS = 9;
+
+/**
+ * Математические ожидания и структурированная ковариация порядковых статистик
+ * @param family - нормальное распределение или Вейбулл
+ * @param n - размер выборки
+ * @param probs - вероятности порядковых статистик (по возрастанию)
+ * @param er - математические ожидания (output)
+ * @param cov - полуразделимое представление ковариации (output)
+ */
+void order_covariance_structured(OrderFamily family, int n, const std::vector<double>& probs,
+                                 Vector& er, OrderCovariance& cov);
+
+/**
+ * Произведение out = V z за O(m)
+ */
+void order_covariance_apply(const OrderCovariance& cov, const double* z, double* out);
+
+/**
+ * Решение V z = rhs методом сопряженных градиентов с трехдиагональным предобуславливателем
+ * @return число итераций
+ */
+int order_covariance_solve(const OrderCovariance& cov, const std::vector<double>& rhs, std::vector<double>& z);
+
+/**
+ * Обобщенный МНК со структурированной ковариацией порядковых статистик.
+ * Системы V w = x_k решаются методом сопряженных градиентов с трехдиагональным
+ * предобуславливателем (главный член ковариации); время и память - O(m)
+ * на итерацию, число итераций мало, так как V отличается от главного члена на O(1/n).
+ * Параметры как у MleastSquare_weight, но V задана структурно.
+ * @return число итераций метода сопряженных градиентов (максимум по столбцам x)
+ */
+int MleastSquare_structured(const Matrix& x, const Matrix& y, const OrderCovariance& v,
+                            Matrix& db, Matrix& b, Vector& yr);
+
+/**
+ * Пиковая память MLS-оценки по m порядковым статистикам со структурированной
+ * ковариацией (генераторы, X, y, V^{-1} X и векторы метода сопряженных градиентов), байт
+ */
+size_t order_structured_memory(size_t m);
+
 // ========== Вспомогательные функции для MLS ==========
 
 /**
  * Вычисление эмпирической функции распределения
+ * @param n - размер выборки (включая цензурированные наблюдения)
+ * @param x - данные
+ * @param r - индикаторы цензурирования (0 - отказ, 1 - цензура)
+ * @param km - число отказов
+ * @param fcum - вероятности порядковых статистик отказов (output, km);
+ *               при цензуре - по скорректированным рангам Джонсона
+ * @param ycum - упорядоченные отказы (output, km)
  */
 void cum(int n, const std::vector<double>& x, const std::vector<int>& r, int km,
          std::vector<double>& fcum, std::vector<double>& ycum);
 
+/**
+ * То же для буферов вызывающего: упорядочение выполняется в рабочей области ws
+ * @param r - индикаторы цензурирования или nullptr для полной выборки
+ */
+void cum(int n, const double* x, const int* r, int km, double* fcum, double* ycum, GlsWorkspace& ws);
+
 /**
  * Вычисление начальных оценок параметров
  */
 void standart(int km, const std::vector<double>& ycum, double& cp, double& cko);
+void standart(int km, const double* ycum, double& cp, double& cko);
+
+// Точность разложения V в плотном взвешенном МНК
+enum GlsPrecision {
+    GLS_PRECISION_DOUBLE,   // разложение Холецкого в double, по умолчанию
+    GLS_PRECISION_MIXED     // разложение во float + итерационное уточнение (CholeskySolveMixed)
+};
+
+/**
+ * Выбор точности для MleastSquare_weight с плотной V. Смешанная точность
+ * выгодна для больших n (разложение - O(n^3), уточнение - O(n^2) на шаг);
+ * при плохой обусловленности V решение автоматически пересчитывается в double.
+ * Упакованный и структурированный пути всегда работают в double.
+ */
+void gls_set_precision(GlsPrecision precision);
+
+/**
+ * Текущая точность плотного взвешенного МНК
+ */
+GlsPrecision gls_precision();
 
 /**
- * Взвешенный МНК (обобщенный метод наименьших квадратов) через Boost.uBLAS
+ * Взвешенный МНК (обобщенный метод наименьших квадратов) через разложение Холецкого V
+ * без явного обращения V и транспонирования X
  * @param x - матрица регрессоров (n x k)
  * @param y - вектор наблюдений (n x 1)
- * @param v - ковариационная матрица ошибок (n x n)
+ * @param v - ковариационная матрица ошибок (n x n), симметричная положительно определенная
  * @param db - выходная ковариационная матрица параметров (k x k)
  * @param b - выходной вектор оценок параметров (k x 1)
  * @param yr - предсказанные значения (n)
+ * @param refinement - при GLS_PRECISION_MIXED: число шагов уточнения и переход
+ *                     на double (output, может быть nullptr)
  */
 void MleastSquare_weight(const Matrix& x, const Matrix& y, const Matrix& v,
+                         Matrix& db, Matrix& b, Vector& yr,
+                         RefinementReport* refinement = nullptr);
+
+/**
+ * Взвешенный МНК с упакованной симметричной ковариационной матрицей ошибок
+ * (разложение Холецкого в упакованном виде, вдвое меньше памяти)
+ */
+void MleastSquare_weight(const Matrix& x, const Matrix& y, const SymmetricMatrix& v,
                          Matrix& db, Matrix& b, Vector& yr);
 
+/**
+ * То же с рабочей областью: множитель Холецкого и "отбеленные" X, y берутся из ws.
+ * При повторных вызовах с выходами того же размера память не выделяется.
+ */
+void MleastSquare_weight(const Matrix& x, const Matrix& y, const SymmetricMatrix& v,
+                         Matrix& db, Matrix& b, Vector& yr, GlsWorkspace& ws);
+
+/**
+ * Взвешенный МНК по моментам порядковых статистик: регрессия ycum = b0 + b1 * E,
+ * E и V - ожидания и ковариации порядковых статистик семейства family
+ * с вероятностями fcum (упакованная V). Все буферы берутся из рабочей области,
+ * поэтому в установившемся режиме вызов не выделяет память.
+ * @param n - размер выборки
+ * @param fcum, ycum - вероятности и упорядоченные значения (m)
+ * @param b - оценки (b0, b1) (output)
+ * @param db - ковариационная матрица оценок 2 x 2 по строкам (output)
+ */
+void MleastSquare_order(OrderFamily family, int n, const double* fcum, const double* ycum, size_t m,
+                        GlsWorkspace& ws, double* b, double* db);
+
+/**
+ * Емкость рабочей области (в double), достаточная для MLS-оценки
+ * по m порядковым статистикам: GlsWorkspace ws(mls_workspace_size(max_n))
+ */
+size_t mls_workspace_size(size_t m);
+
 #endif // ORDER_H
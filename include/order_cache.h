@@ -0,0 +1,62 @@
+#ifndef ORDER_CACHE_H
+#define ORDER_CACHE_H
+
+#include <string>
+#include "order.h"
+
+// ========== Кеш таблиц порядковых статистик для полных выборок ==========
+
+/**
+ * Таблица моментов порядковых статистик полной выборки объема n.
+ * Для полной выборки вероятности равны i/(n+1), поэтому таблица не зависит
+ * от данных, и вместе с ней хранятся готовые веса обобщенного МНК
+ * для регрессии y = b0 + b1 * E: b = W * ycum.
+ * Все массивы хранятся по строкам и принадлежат кешу.
+ */
+struct OrderTable {
+    int family;         // OrderFamily
+    int n;              // размер выборки
+    int order;          // порядок разложения Дэйвида-Джонсона
+    const double* er;   // математические ожидания (n)
+    const double* v;    // ковариационная матрица (n x n)
+    const double* w;    // веса ОМНК W = (X^T V^{-1} X)^{-1} X^T V^{-1} (2 x n)
+    const double* db;   // ковариационная матрица оценок (X^T V^{-1} X)^{-1} (2 x 2)
+};
+
+/**
+ * Директория для файлов таблиц.
+ * По умолчанию берется из переменной окружения AGAMIROV_ORDER_CACHE;
+ * пустая строка отключает кеш.
+ */
+void order_cache_set_dir(const std::string& dir);
+
+/**
+ * Включен ли кеш (задана ли директория)
+ */
+bool order_cache_enabled();
+
+// Построение таблицы, которой нет ни в памяти процесса, ни в файле
+enum OrderTableBuild {
+    ORDER_TABLE_DENSE,  // плотные V, ее множитель Холецкого и таблица в памяти: ~3 n² double
+    ORDER_TABLE_TILED,  // V пишется в файл блоками строк, веса - структурированным МНК: O(n) памяти
+    ORDER_TABLE_NONE    // не строить: только готовая таблица
+};
+
+/**
+ * Таблица для (family, n) при текущем порядке разложения (order_expansion): берется из памяти процесса, отображается (mmap)
+ * из файла прошлого запуска или строится способом build и записывается в файл.
+ * Блочная таблица сразу отображается из записанного файла, поэтому без возможности
+ * записи не строится. Веса блочной таблицы получены методом сопряженных градиентов
+ * и совпадают с плотными в пределах погрешности решения системы.
+ * Указатель действителен до завершения процесса.
+ * @return nullptr, если кеш отключен или таблицу не удалось получить
+ */
+const OrderTable* order_table(OrderFamily family, int n, OrderTableBuild build = ORDER_TABLE_DENSE);
+
+/**
+ * Пиковая память (байт) получения таблицы объема n способом build;
+ * для ORDER_TABLE_NONE - читаемая часть отображенного файла (веса)
+ */
+size_t order_table_memory(int n, OrderTableBuild build);
+
+#endif // ORDER_CACHE_H
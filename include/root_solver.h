@@ -0,0 +1,86 @@
+#ifndef ROOT_SOLVER_H
+#define ROOT_SOLVER_H
+
+#include <cmath>
+#include <limits>
+
+// ========== Корень уравнения с одной переменной ==========
+
+/**
+ * Результат newton_bracketed
+ */
+struct RootResult {
+    double root = 0.0;      // найденный корень
+    double value = 0.0;     // значение функции в нем
+    int evaluations = 0;    // вычислений функции с производной
+    bool converged = false; // флаг сходимости
+};
+
+/**
+ * Корень f(x) = 0 между точками neg и pos, где f(neg) < 0 < f(pos) (порядок
+ * любой; значения на концах известны вызывающему и заново не вычисляются):
+ * метод Ньютона с защитой бисекцией. Шаг Ньютона принимается, если он остается
+ * внутри текущего отрезка и не больше половины шага перед предыдущим, иначе
+ * делается шаг бисекции. Отрезок сужается после каждого вычисления, поэтому
+ * сходимость гарантирована, а вблизи простого корня она квадратичная.
+ * func вычисляет значение и производную за один вызов:
+ *   double func(double x, double& derivative).
+ * Остановка - при f(x) = 0, поправке Ньютона или ширине отрезка меньше 4 eps |x|.
+ * @param neg, pos - концы отрезка: f(neg) < 0, f(pos) > 0
+ * @param x0 - начальное приближение (вне отрезка - его середина)
+ * @param func - функция с производной
+ * @param max_eval - максимальное число вычислений func
+ */
+template <typename F>
+RootResult newton_bracketed(double neg, double pos, double x0, F&& func, int max_eval = 100) {
+    const double eps = std::numeric_limits<double>::epsilon();
+    RootResult result;
+    double lo = neg, hi = pos;      // f(lo) < 0 < f(hi)
+
+    double x = ((x0 - lo) * (x0 - hi) < 0.0) ? x0 : 0.5 * (lo + hi);
+    double step = std::abs(hi - lo);
+    double step_before = step;
+    double d;
+    double f = func(x, d);
+    result.evaluations++;
+
+    while (result.evaluations < max_eval) {
+        if (f == 0.0) {
+            result.converged = true;
+            break;
+        }
+        if (f < 0.0) lo = x; else hi = x;
+
+        // Поправка Ньютона на уровне округления x: корень найден
+        double newton = (d != 0.0) ? x - f / d : std::numeric_limits<double>::quiet_NaN();
+        if (std::abs(newton - x) <= 4.0 * eps * std::abs(x)) {
+            result.converged = true;
+            break;
+        }
+        double step_prev = step_before;
+        step_before = step;
+        bool inside = (newton - lo) * (newton - hi) < 0.0;
+        if (inside && std::abs(2.0 * f) <= std::abs(step_prev * d)) {
+            step = newton - x;
+            x = newton;
+        } else {
+            step = 0.5 * (hi - lo);
+            x = lo + step;
+        }
+
+        if (std::abs(step) <= 4.0 * eps * std::abs(x) || std::abs(hi - lo) <= 4.0 * eps * std::abs(x)) {
+            f = func(x, d);
+            result.evaluations++;
+            result.converged = true;
+            break;
+        }
+        f = func(x, d);
+        result.evaluations++;
+    }
+
+    result.root = x;
+    result.value = f;
+    return result;
+}
+
+#endif // ROOT_SOLVER_H
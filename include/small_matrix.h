@@ -0,0 +1,247 @@
+#ifndef SMALL_MATRIX_H
+#define SMALL_MATRIX_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// ========== Малые матрицы фиксированного размера ==========
+
+/**
+ * Квадратная матрица N x N по строкам в автоматической памяти - для информационных
+ * и ковариационных матриц 2- и 3-параметрических моделей. В отличие от Matrix
+ * (uBLAS, куча) не выделяет память; все операции constexpr.
+ * Определитель и обратная матрица - в явном виде для Mat2 и Mat3.
+ */
+template <size_t N>
+struct SmallMatrix {
+    double a[N * N] = {};
+
+    constexpr double& operator()(size_t i, size_t j) { return a[i * N + j]; }
+    constexpr const double& operator()(size_t i, size_t j) const { return a[i * N + j]; }
+
+    /**
+     * Элементы по строкам (для функций, принимающих double*)
+     */
+    constexpr double* data() { return a; }
+    constexpr const double* data() const { return a; }
+
+    static constexpr size_t size() { return N; }
+
+    static constexpr SmallMatrix identity() {
+        SmallMatrix m;
+        for (size_t i = 0; i < N; i++) m(i, i) = 1.0;
+        return m;
+    }
+
+    /**
+     * Матрица из N x N элементов по строкам
+     */
+    static constexpr SmallMatrix from_rows(const double* p) {
+        SmallMatrix m;
+        for (size_t i = 0; i < N * N; i++) m.a[i] = p[i];
+        return m;
+    }
+};
+
+typedef SmallMatrix<2> Mat2;
+typedef SmallMatrix<3> Mat3;
+
+template <size_t N>
+constexpr SmallMatrix<N> operator+(const SmallMatrix<N>& x, const SmallMatrix<N>& y) {
+    SmallMatrix<N> m;
+    for (size_t i = 0; i < N * N; i++) m.a[i] = x.a[i] + y.a[i];
+    return m;
+}
+
+template <size_t N>
+constexpr SmallMatrix<N> operator-(const SmallMatrix<N>& x, const SmallMatrix<N>& y) {
+    SmallMatrix<N> m;
+    for (size_t i = 0; i < N * N; i++) m.a[i] = x.a[i] - y.a[i];
+    return m;
+}
+
+template <size_t N>
+constexpr SmallMatrix<N> operator*(double c, const SmallMatrix<N>& x) {
+    SmallMatrix<N> m;
+    for (size_t i = 0; i < N * N; i++) m.a[i] = c * x.a[i];
+    return m;
+}
+
+template <size_t N>
+constexpr SmallMatrix<N> operator*(const SmallMatrix<N>& x, const SmallMatrix<N>& y) {
+    SmallMatrix<N> m;
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j < N; j++) {
+            double s = 0.0;
+            for (size_t k = 0; k < N; k++) s += x(i, k) * y(k, j);
+            m(i, j) = s;
+        }
+    }
+    return m;
+}
+
+template <size_t N>
+constexpr SmallMatrix<N> transpose(const SmallMatrix<N>& x) {
+    SmallMatrix<N> m;
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j < N; j++) m(i, j) = x(j, i);
+    }
+    return m;
+}
+
+/**
+ * D X D для D = diag(g): ковариация после дельта-метода с диагональным якобианом
+ */
+template <size_t N>
+constexpr SmallMatrix<N> scale_symmetric(const SmallMatrix<N>& x, const double (&g)[N]) {
+    SmallMatrix<N> m;
+    for (size_t i = 0; i < N; i++) {
+        for (size_t j = 0; j < N; j++) m(i, j) = g[i] * g[j] * x(i, j);
+    }
+    return m;
+}
+
+constexpr double determinant(const Mat2& m) {
+    return m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0);
+}
+
+constexpr double determinant(const Mat3& m) {
+    return m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) -
+           m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0)) +
+           m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+}
+
+/**
+ * Обратная матрица через присоединенную: adj(m) / det(m).
+ * Нулевой определитель - исключение std::runtime_error.
+ */
+constexpr Mat2 inverse(const Mat2& m) {
+    double det = determinant(m);
+    if (det == 0.0) {
+        throw std::runtime_error("Матрица вырожденная, обращение невозможно");
+    }
+    Mat2 r;
+    r(0, 0) = m(1, 1) / det;
+    r(0, 1) = -m(0, 1) / det;
+    r(1, 0) = -m(1, 0) / det;
+    r(1, 1) = m(0, 0) / det;
+    return r;
+}
+
+constexpr Mat3 inverse(const Mat3& m) {
+    double det = determinant(m);
+    if (det == 0.0) {
+        throw std::runtime_error("Матрица вырожденная, обращение невозможно");
+    }
+    Mat3 r;
+    r(0, 0) = (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) / det;
+    r(0, 1) = (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)) / det;
+    r(0, 2) = (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)) / det;
+    r(1, 0) = (m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2)) / det;
+    r(1, 1) = (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)) / det;
+    r(1, 2) = (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)) / det;
+    r(2, 0) = (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0)) / det;
+    r(2, 1) = (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)) / det;
+    r(2, 2) = (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)) / det;
+    return r;
+}
+
+/**
+ * Решение A x = b для симметричной A разложением Холецкого A = L L^T
+ * (копия a раскладывается на месте, b заменяется решением).
+ * Возвращает false, если A не положительно определена; b тогда не определено.
+ */
+template <size_t N>
+bool cholesky_solve(SmallMatrix<N> a, std::array<double, N>& b) {
+    for (size_t j = 0; j < N; j++) {
+        double d = a(j, j);
+        for (size_t k = 0; k < j; k++) d -= a(j, k) * a(j, k);
+        if (!(d > 0.0)) return false;
+        a(j, j) = std::sqrt(d);
+        for (size_t i = j + 1; i < N; i++) {
+            double s = a(i, j);
+            for (size_t k = 0; k < j; k++) s -= a(i, k) * a(j, k);
+            a(i, j) = s / a(j, j);
+        }
+    }
+    for (size_t i = 0; i < N; i++) {
+        for (size_t k = 0; k < i; k++) b[i] -= a(i, k) * b[k];
+        b[i] /= a(i, i);
+    }
+    for (size_t i = N; i-- > 0;) {
+        for (size_t k = i + 1; k < N; k++) b[i] -= a(k, i) * b[k];
+        b[i] /= a(i, i);
+    }
+    return true;
+}
+
+// ========== Ковариационная матрица параметров ==========
+
+/**
+ * Квадратная матрица n x n по строкам, размер задается при выполнении
+ * (число параметров модели: 2, 3 или k + 1 для k подвыборок).
+ * До INLINE_SIZE x INLINE_SIZE элементы хранятся внутри объекта и память
+ * не выделяется; большие матрицы - в std::vector. Обычное значение:
+ * копируется, перемещается и освобождается автоматически.
+ */
+class CovarianceMatrix {
+public:
+    static const size_t INLINE_SIZE = 3;
+
+    CovarianceMatrix() = default;
+
+    /**
+     * Нулевая матрица n x n
+     */
+    explicit CovarianceMatrix(size_t n) : n(n) {
+        if (n > INLINE_SIZE) heap.assign(n * n, 0.0);
+    }
+
+    template <size_t N>
+    CovarianceMatrix(const SmallMatrix<N>& m) : CovarianceMatrix(N) {
+        std::copy(m.a, m.a + N * N, data());
+    }
+
+    CovarianceMatrix(const CovarianceMatrix&) = default;
+    CovarianceMatrix& operator=(const CovarianceMatrix&) = default;
+
+    // Перемещенный объект остается пустой матрицей 0 x 0
+    CovarianceMatrix(CovarianceMatrix&& other) noexcept
+        : n(other.n), heap(std::move(other.heap)) {
+        std::copy(other.local, other.local + INLINE_SIZE * INLINE_SIZE, local);
+        other.n = 0;
+        other.heap.clear();
+    }
+
+    CovarianceMatrix& operator=(CovarianceMatrix&& other) noexcept {
+        if (this != &other) {
+            n = other.n;
+            heap = std::move(other.heap);
+            std::copy(other.local, other.local + INLINE_SIZE * INLINE_SIZE, local);
+            other.n = 0;
+            other.heap.clear();
+        }
+        return *this;
+    }
+
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+
+    double& operator()(size_t i, size_t j) { return data()[i * n + j]; }
+    const double& operator()(size_t i, size_t j) const { return data()[i * n + j]; }
+
+    double* data() { return n > INLINE_SIZE ? heap.data() : local; }
+    const double* data() const { return n > INLINE_SIZE ? heap.data() : local; }
+
+private:
+    size_t n = 0;
+    double local[INLINE_SIZE * INLINE_SIZE] = {};
+    std::vector<double> heap;
+};
+
+#endif // SMALL_MATRIX_H
@@ -0,0 +1,73 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ========== Пул потоков для параллельных циклов ==========
+
+/**
+ * Пул рабочих потоков с динамической раздачей итераций.
+ * Вызывающий поток участвует в работе наравне с рабочими.
+ * Вложенный вызов из рабочего потока, а также вызов при занятом пуле
+ * выполняются последовательно в вызывающем потоке.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Число потоков, включая вызывающий
+     */
+    int size() const { return int(workers.size()) + 1; }
+
+    /**
+     * Выполнение body(k) для k = 0..count-1
+     * Возврат - после завершения всех итераций. Если body бросает исключение,
+     * новые итерации не раздаются; после завершения уже начатых первое
+     * исключение передается вызывающему потоку (при любом числе потоков).
+     */
+    void parallel_for(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    void worker_loop();
+    void run_tasks();
+
+    std::vector<std::thread> workers;
+    std::mutex submit_mutex;            // один параллельный цикл за раз
+    std::mutex state_mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* job = nullptr;
+    size_t job_count = 0;
+    std::atomic<size_t> next_index{0};
+    int busy_workers = 0;
+    std::exception_ptr error;           // первое исключение текущего цикла
+    unsigned long generation = 0;
+    bool stopping = false;
+};
+
+/**
+ * Общий пул процесса. Размер по умолчанию - переменная окружения
+ * AGAMIROV_THREADS или число аппаратных потоков.
+ */
+ThreadPool& global_thread_pool();
+
+/**
+ * Пересоздание общего пула с заданным числом потоков (0 - по умолчанию).
+ * Вызывать, когда пул не используется.
+ */
+void set_thread_count(int threads);
+
+#endif // THREAD_POOL_H
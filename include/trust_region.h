@@ -0,0 +1,174 @@
+#ifndef TRUST_REGION_H
+#define TRUST_REGION_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include "small_matrix.h"
+
+// ========== Метод Ньютона с доверительной областью ==========
+
+/**
+ * Параметры остановки
+ */
+struct TrustRegionOptions {
+    double tol = 1e-10;     // порог g^T H^{-1} g / 2 (ожидаемого уменьшения до минимума)
+                            // относительно max(1, |f|)
+    int max_iter = 100;     // максимальное число итераций (вычислений функции)
+    double lambda0 = 1e-3;  // начальный сдвиг lambda (доля max |H_jj|) после первого отказа от шага
+};
+
+// Попыток увеличить сдвиг lambda на одном шаге; удвоение nu дает рост
+// быстрее экспоненты, поэтому 64 попыток хватает с запасом до переполнения
+const int TRUST_REGION_MAX_SHIFTS = 64;
+
+/**
+ * Результат newton_trust_region<N>
+ */
+template <size_t N>
+struct TrustRegionResult {
+    std::array<double, N> parameters{};    // точка минимума
+    double final_value = 0.0;               // значение функции в ней
+    std::array<double, N> gradient{};       // градиент в ней
+    SmallMatrix<N> hessian;                 // гессиан в ней (для -log L - наблюдаемая информация)
+    int iterations = 0;                     // принятых шагов
+    int evaluations = 0;                    // вычислений функции с производными
+    bool converged = false;                 // флаг сходимости
+};
+
+/**
+ * Минимизация гладкой функции N параметров методом Ньютона с доверительной
+ * областью в форме Левенберга-Марквардта: шаг p решает (H + lambda I) p = -g.
+ * При lambda = 0 это чистый шаг Ньютона (квадратичная сходимость вблизи минимума);
+ * если функция уменьшилась хуже, чем предсказывает квадратичная модель,
+ * или H не положительно определена, lambda увеличивается (область сужается),
+ * после удачных шагов - уменьшается (правило Нильсена), а после шага,
+ * уменьшение на котором близко к предсказанному, сбрасывается в ноль.
+ * func вычисляет значение, градиент и гессиан за один вызов:
+ *   double func(const std::array<double, N>& x, std::array<double, N>& g, SmallMatrix<N>& h).
+ * Нечисловое значение (inf, nan), например вне области параметров, означает отказ от шага.
+ * Если H + lambda I не разлагается ни при каком сдвиге (nan в гессиане),
+ * поиск прекращается с converged = false в последней принятой точке.
+ * Остановка - когда при положительно определенной H ожидаемое уменьшение
+ * g^T H^{-1} g / 2 меньше options.tol * max(1, |f|): тогда делается последний
+ * полный шаг Ньютона, и гессиан возвращается уже в новой точке.
+ * @param x0 - начальная точка (значение func в ней должно быть конечным)
+ * @param options - параметры остановки
+ * @param func - функция с производными
+ */
+template <size_t N, typename F>
+TrustRegionResult<N> newton_trust_region(const std::array<double, N>& x0, const TrustRegionOptions& options,
+                                         F&& func) {
+    static_assert(N > 0, "нужен хотя бы один параметр");
+    typedef std::array<double, N> Point;
+
+    TrustRegionResult<N> result;
+    Point x = x0;
+    Point g;
+    SmallMatrix<N> h;
+    double f = func(x, g, h);
+    result.evaluations = 1;
+
+    double lambda = 0.0;
+    double nu = 2.0;
+    while (std::isfinite(f) && result.evaluations < options.max_iter) {
+        double scale = 0.0;
+        for (size_t j = 0; j < N; j++) scale = std::max(scale, std::abs(h(j, j)));
+        if (scale == 0.0) scale = 1.0;
+
+        // Ньютоновский шаг H p = -g и критерий остановки по декременту
+        Point p;
+        for (size_t j = 0; j < N; j++) p[j] = -g[j];
+        if (cholesky_solve(h, p)) {
+            double decrement = 0.0;
+            for (size_t j = 0; j < N; j++) decrement -= g[j] * p[j];
+            if (decrement / 2.0 < options.tol * std::max(1.0, std::abs(f))) {
+                // Последний шаг Ньютона без проверки уменьшения: оно уже сравнимо
+                // с округлением f, а ошибка после шага - порядка квадрата текущей
+                Point x_new;
+                for (size_t j = 0; j < N; j++) x_new[j] = x[j] + p[j];
+                Point g_new;
+                SmallMatrix<N> h_new;
+                double f_new = func(x_new, g_new, h_new);
+                result.evaluations++;
+                if (std::isfinite(f_new)) {
+                    x = x_new;
+                    f = f_new;
+                    g = g_new;
+                    h = h_new;
+                    result.iterations++;
+                }
+                result.converged = true;
+                break;
+            }
+        } else if (lambda == 0.0) {
+            lambda = options.lambda0 * scale;
+        }
+
+        // Шаг в доверительной области: (H + lambda I) p = -g,
+        // не положительно определенная матрица - сдвиг больше. Число сдвигов
+        // ограничено: при nan в H разложение не удается ни при каком lambda
+        if (lambda > 0.0) {
+            SmallMatrix<N> shifted = h;
+            bool solved = false;
+            for (int attempt = 0; attempt < TRUST_REGION_MAX_SHIFTS && std::isfinite(lambda); attempt++) {
+                for (size_t j = 0; j < N; j++) {
+                    shifted(j, j) = h(j, j) + lambda;
+                    p[j] = -g[j];
+                }
+                if (cholesky_solve(shifted, p)) {
+                    solved = true;
+                    break;
+                }
+                lambda *= nu;
+                nu *= 2.0;
+            }
+            if (!solved) break;
+        }
+
+        // Предсказанное моделью уменьшение: -(g^T p + p^T H p / 2)
+        double gp = 0.0, php = 0.0;
+        for (size_t i = 0; i < N; i++) {
+            gp += g[i] * p[i];
+            for (size_t j = 0; j < N; j++) php += p[i] * h(i, j) * p[j];
+        }
+        double predicted = -(gp + php / 2.0);
+
+        Point x_new;
+        for (size_t j = 0; j < N; j++) x_new[j] = x[j] + p[j];
+        Point g_new;
+        SmallMatrix<N> h_new;
+        double f_new = func(x_new, g_new, h_new);
+        result.evaluations++;
+
+        double rho = (std::isfinite(f_new) && predicted > 0.0) ? (f - f_new) / predicted : -1.0;
+        if (rho > 0.0) {
+            x = x_new;
+            f = f_new;
+            g = g_new;
+            h = h_new;
+            result.iterations++;
+            // Модель хорошо предсказывает уменьшение - снова полный шаг Ньютона
+            if (rho > 0.75) {
+                lambda = 0.0;
+            } else {
+                double t = 2.0 * rho - 1.0;
+                lambda *= std::max(1.0 / 3.0, 1.0 - t * t * t);
+            }
+            nu = 2.0;
+        } else {
+            // Шаг отвергнут: x, f и производные не меняются
+            lambda = (lambda == 0.0) ? options.lambda0 * scale : lambda * nu;
+            nu *= 2.0;
+        }
+    }
+
+    result.parameters = x;
+    result.final_value = f;
+    result.gradient = g;
+    result.hessian = h;
+    return result;
+}
+
+#endif // TRUST_REGION_H
@@ -135,7 +135,7 @@ int main() {
     cout << "\nПрограмма выполняет оценку параметров для:" << endl;
     cout << "  1. Нормального распределения - MLE (полные данные)" << endl;
     cout << "  2. Нормального распределения - MLS через метод Агамирова (полные данные)" << endl;
-    cout << "  3. Распределения Вейбулла - MLE (полные данные)" << endl;
+    cout << "  3. Распределения Вейбулла - MLE и MLS (полные данные)" << endl;
     cout << "  4. Статистические критерии (Граббса, Фишера, Стьюдента)" << endl;
     cout << "  5. Доверительные интервалы и персентили" << endl;
 
@@ -174,8 +174,39 @@ int main() {
         cout << "Результаты сохранены в output/mls_normal_complete.txt" << endl;
     }
 
+    // Цензурированные данные: система строится только по отказам
+    vector<double> censored_normal_data;
+    vector<int> censored_normal_flags;
+    read_censored_data("input/data_censored_normal.txt", censored_normal_data, censored_normal_flags);
+
+    if (!censored_normal_data.empty()) {
+        cout << "\nВыполняется MLS для нормального распределения (цензурированные данные)..." << endl;
+        MLEResult result_normal_cens = mls_normal_progressive(censored_normal_data, censored_normal_flags);
+
+        print_mle_result(result_normal_cens, "MLS Нормальное распределение (цензурированные данные)");
+        save_mle_result(result_normal_cens, "output/mls_normal_censored.txt",
+                        censored_normal_data, censored_normal_flags);
+
+        free_mle_result(result_normal_cens);
+    }
+
+    // Совместная оценка по подвыборкам: общая σ, свои μ (первая и вторая половины)
+    if (normal_data.size() >= 4) {
+        int mid = normal_data.size() / 2;
+        vector<int> nsample = {mid, int(normal_data.size()) - mid};
+        vector<int> complete_flags(normal_data.size(), 0);
+
+        cout << "\nВыполняется совместный MLS по двум подвыборкам (общая σ)..." << endl;
+        MLEResult result_normal_joint = mls_normal_multisample(normal_data, complete_flags, nsample);
+
+        print_mle_result(result_normal_joint, "MLS Нормальное распределение (μ1, μ2, общая σ)");
+        save_mle_result(result_normal_joint, "output/mls_normal_multisample.txt", normal_data, complete_flags);
+
+        free_mle_result(result_normal_joint);
+    }
+
     // ==================== 3. РАСПРЕДЕЛЕНИЕ ВЕЙБУЛЛА (полные данные) ====================
-    print_separator("3. РАСПРЕДЕЛЕНИЕ ВЕЙБУЛЛА - MLE (ПОЛНЫЕ ДАННЫЕ)");
+    print_separator("3. РАСПРЕДЕЛЕНИЕ ВЕЙБУЛЛА - MLE И MLS (ПОЛНЫЕ ДАННЫЕ)");
 
     string weibull_file = "input/data_weibull.txt";
     vector<double> weibull_data = read_data(weibull_file);
@@ -191,10 +222,36 @@ int main() {
 
         free_mle_result(result_weibull);
         cout << "Результаты сохранены в output/mle_weibull_complete.txt" << endl;
+
+        cout << "\nВыполняется MLS (метод Агамирова - orderw) для распределения Вейбулла..." << endl;
+        MLEResult result_weibull_mls = mls_weibull_complete(weibull_data);
+
+        print_mle_result(result_weibull_mls, "MLS Распределение Вейбулла (метод Агамирова)");
+        save_mle_result(result_weibull_mls, "output/mls_weibull_complete.txt", weibull_data, vector<int>());
+
+        free_mle_result(result_weibull_mls);
+        cout << "Результаты сохранены в output/mls_weibull_complete.txt" << endl;
     } else {
         cerr << "Ошибка: не удалось загрузить данные для распределения Вейбулла" << endl;
     }
 
+    vector<double> censored_weibull_data;
+    vector<int> censored_weibull_flags;
+    read_censored_data("input/data_censored_weibull.txt", censored_weibull_data, censored_weibull_flags);
+
+    if (!censored_weibull_data.empty()) {
+        cout << "\nВыполняется MLS для распределения Вейбулла (цензурированные данные)..." << endl;
+        MLEResult result_weibull_cens = mls_weibull_progressive(censored_weibull_data, censored_weibull_flags);
+
+        print_mle_result(result_weibull_cens, "MLS Распределение Вейбулла (цензурированные данные)");
+        save_mle_result(result_weibull_cens, "output/mls_weibull_censored.txt",
+                        censored_weibull_data, censored_weibull_flags);
+
+        free_mle_result(result_weibull_cens);
+    } else {
+        cerr << "Ошибка: не удалось загрузить цензурированные данные для распределения Вейбулла" << endl;
+    }
+
     // ==================== 4. СТАТИСТИЧЕСКИЕ КРИТЕРИИ ====================
     print_separator("4. СТАТИСТИЧЕСКИЕ КРИТЕРИИ");
 
@@ -339,6 +396,9 @@ int main() {
     cout << "  - Визуализация MLE для распределения Вейбулла..." << endl;
     run_python_script("plot_weibull.py", "mle");
 
+    cout << "  - Визуализация MLS для распределения Вейбулла..." << endl;
+    run_python_script("plot_weibull.py", "mls");
+
     cout << "  - Визуализация распределения Стьюдента (3 графика)..." << endl;
     run_python_script("plot_t_distribution.py");
 
@@ -347,6 +407,7 @@ int main() {
     cout << "  - output/plot_mle_normal.png" << endl;
     cout << "  - output/plot_mls_normal.png" << endl;
     cout << "  - output/plot_mle_weibull.png" << endl;
+    cout << "  - output/plot_mls_weibull.png" << endl;
     cout << "  - output/plot_t_varying_df.png (неизвестная σ)" << endl;
     cout << "  - output/plot_normal_varying_sigma.png (известная σ)" << endl;
     cout << "  - output/plot_chi_squared.png (неизвестное μ)" << endl;
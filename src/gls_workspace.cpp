@@ -0,0 +1,76 @@
+#include "gls_workspace.h"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+// Буферы выровнены на строку кеша (и на ширину вектора AVX-512)
+static const size_t GLS_ALIGN_DOUBLES = 8;
+
+static double* gls_allocate(size_t count) {
+    return static_cast<double*>(::operator new(count * sizeof(double), std::align_val_t(64)));
+}
+
+static void gls_free(double* p) {
+    ::operator delete(p, std::align_val_t(64));
+}
+
+size_t GlsWorkspace::slice(size_t count) {
+    return (count + GLS_ALIGN_DOUBLES - 1) / GLS_ALIGN_DOUBLES * GLS_ALIGN_DOUBLES;
+}
+
+GlsWorkspace::GlsWorkspace(size_t doubles) {
+    if (doubles > 0) {
+        cap = slice(doubles);
+        base = gls_allocate(cap);
+        allocs++;
+    }
+}
+
+GlsWorkspace::~GlsWorkspace() {
+    while (overflow_count > 0) {
+        gls_free(overflow[--overflow_count]);
+    }
+    if (base != nullptr) gls_free(base);
+}
+
+double* GlsWorkspace::take(size_t count) {
+    size_t size = slice(count);
+    double* p;
+
+    if (used + size <= cap) {
+        p = base + used;
+        used += size;
+    } else {
+        // Блока не хватило: отдельный кусок до освобождения всех буферов
+        if (overflow_count == MAX_OVERFLOW) {
+            throw std::runtime_error("Рабочая область МНК: слишком много дополнительных буферов");
+        }
+        p = gls_allocate(size);
+        allocs++;
+        overflow[overflow_count] = p;
+        overflow_size[overflow_count] = size;
+        overflow_count++;
+        overflow_total += size;
+    }
+
+    demand = std::max(demand, used + overflow_total);
+    return p;
+}
+
+void GlsWorkspace::release(size_t mark, size_t chunks) {
+    used = mark;
+    while (overflow_count > chunks) {
+        overflow_count--;
+        overflow_total -= overflow_size[overflow_count];
+        gls_free(overflow[overflow_count]);
+    }
+
+    // Все буферы свободны: блок расширяется до наибольшей потребности,
+    // чтобы следующая оценка того же размера обошлась без выделений
+    if (used == 0 && overflow_count == 0 && demand > cap) {
+        if (base != nullptr) gls_free(base);
+        base = gls_allocate(demand);
+        cap = demand;
+        allocs++;
+    }
+}
@@ -1,11 +1,493 @@
 #include "matrix_operations.h"
+#include "thread_pool.h"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <cmath>
+#include <cstring>
 #include <stdexcept>
+#include <vector>
 #include <boost/numeric/ublas/lu.hpp>
+#include <boost/numeric/ublas/triangular.hpp>
 
 using namespace boost::numeric::ublas;
 
+// ============ Выбор реализации ============
+
+#ifdef AGAMIROV_LAPACK
+static MatrixBackend matrix_backend_requested = MATRIX_BACKEND_LAPACK;
+#else
+static MatrixBackend matrix_backend_requested = MATRIX_BACKEND_NATIVE;
+#endif
+
+bool matrix_lapack_available() {
+#ifdef AGAMIROV_LAPACK
+    return true;
+#else
+    return false;
+#endif
+}
+
+void matrix_set_backend(MatrixBackend backend) {
+    if (backend == MATRIX_BACKEND_LAPACK && !matrix_lapack_available()) {
+        throw std::runtime_error("Программа собрана без LAPACK (make USE_LAPACK=1)");
+    }
+    matrix_backend_requested = backend;
+}
+
+MatrixBackend matrix_backend() {
+    return matrix_backend_requested;
+}
+
+// ============ Адаптер BLAS/LAPACK ============
+// Фортрановские подпрограммы работают с матрицами по столбцам, а Matrix хранится
+// по строкам, поэтому массив по строкам передается как транспонированная матрица:
+//   C = A B        ->  C^T = B^T A^T                  (dgemm)
+//   L по строкам   ->  U = L^T по столбцам, A = U^T U  (dpotrf, 'U')
+//   L Z = B        ->  Z^T U = B^T, правостороннее     (dtrsm, 'R')
+// Упакованный верхний треугольник по строкам совпадает с нижним по столбцам,
+// и хранимая в нем L^T - это L в формате LAPACK ('L', dpptrf/dtpsv).
+
+#ifdef AGAMIROV_LAPACK
+extern "C" {
+void dgemm_(const char* transa, const char* transb, const int* m, const int* n, const int* k,
+            const double* alpha, const double* a, const int* lda, const double* b, const int* ldb,
+            const double* beta, double* c, const int* ldc);
+void dtrsm_(const char* side, const char* uplo, const char* transa, const char* diag,
+            const int* m, const int* n, const double* alpha, const double* a, const int* lda,
+            double* b, const int* ldb);
+void dtpsv_(const char* uplo, const char* trans, const char* diag, const int* n,
+            const double* ap, double* x, const int* incx);
+void dpotrf_(const char* uplo, const int* n, double* a, const int* lda, int* info);
+void spotrf_(const char* uplo, const int* n, float* a, const int* lda, int* info);
+void strsm_(const char* side, const char* uplo, const char* transa, const char* diag,
+            const int* m, const int* n, const float* alpha, const float* a, const int* lda,
+            float* b, const int* ldb);
+void dpptrf_(const char* uplo, const int* n, double* ap, int* info);
+void dgetrf_(const int* m, const int* n, double* a, const int* lda, int* ipiv, int* info);
+void dgetri_(const int* n, double* a, const int* lda, const int* ipiv, double* work,
+             const int* lwork, int* info);
+}
+
+// C (m x n) = A (m x k) * B (k x n), все по строкам
+static void lapack_gemm(int m, int n, int k, const double* a, const double* b, double* c) {
+    const double one = 1.0, zero = 0.0;
+    dgemm_("N", "N", &n, &m, &k, &one, b, &n, a, &k, &zero, c, &n);
+}
+
+static void lapack_cholesky(double* a, int n) {
+    int info = 0;
+    dpotrf_("U", &n, a, &n, &info);
+    if (info != 0) {
+        throw std::runtime_error("Матрица не положительно определена, разложение Холецкого невозможно");
+    }
+}
+
+static void lapack_cholesky(float* a, int n) {
+    int info = 0;
+    spotrf_("U", &n, a, &n, &info);
+    if (info != 0) {
+        throw std::runtime_error("Матрица не положительно определена, разложение Холецкого невозможно");
+    }
+}
+
+// L Z = B (trans = "N") или L^T Z = B (trans = "T"); B - n x k по строкам
+static void lapack_solve_lower(const char* trans, const double* l, int n, double* b, int k) {
+    const double one = 1.0;
+    dtrsm_("R", "U", trans, "N", &k, &n, &one, l, &n, b, &k);
+}
+
+static void lapack_solve_lower(const char* trans, const float* l, int n, float* b, int k) {
+    const float one = 1.0f;
+    strsm_("R", "U", trans, "N", &k, &n, &one, l, &n, b, &k);
+}
+
+static void lapack_cholesky_packed(double* a, int n) {
+    int info = 0;
+    dpptrf_("L", &n, a, &info);
+    if (info != 0) {
+        throw std::runtime_error("Матрица не положительно определена, разложение Холецкого невозможно");
+    }
+}
+
+// Столбцы B (n x k по строкам) - векторы с шагом k
+static void lapack_solve_lower_packed(const char* trans, const double* l, int n, double* b, int k) {
+    for (int q = 0; q < k; q++) {
+        dtpsv_("L", trans, "N", &n, l, b + q, &k);
+    }
+}
+
+static void lapack_inverse(double* a, int n) {
+    std::vector<int> ipiv(n);
+    int info = 0;
+    dgetrf_(&n, &n, a, &n, ipiv.data(), &info);
+    if (info != 0) {
+        throw std::runtime_error("Матрица вырожденная, обращение невозможно");
+    }
+    int lwork = -1;
+    double query = 0.0;
+    dgetri_(&n, a, &n, ipiv.data(), &query, &lwork, &info);
+    lwork = std::max(1, int(query));
+    std::vector<double> work(lwork);
+    dgetri_(&n, a, &n, ipiv.data(), work.data(), &lwork, &info);
+    if (info != 0) {
+        throw std::runtime_error("Матрица вырожденная, обращение невозможно");
+    }
+}
+#endif
+
+// ============ Блочное умножение матриц ============
+// C += alpha * A * B по схеме Гото: полоса B (KC x NC) и блок A (MC x KC)
+// упаковываются в непрерывные панели шириной NR и MR, после чего
+// микроядро считает плитку MR x NR целиком в регистрах.
+// Элементы A и B задаются шагами по строке и столбцу, поэтому
+// транспонированные операнды (L^T, P^T) не копируются.
+// Ядра параметризованы типом элемента: float (разложение в пониженной
+// точности) занимает в векторе вдвое больше дорожек, поэтому NR у него вдвое шире.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_SIMD_X86 1
+typedef double matrix_v4d __attribute__((vector_size(32)));
+typedef float matrix_v8f __attribute__((vector_size(32)));
+#endif
+
+static const size_t GEMM_MR = 6;        // строк в плитке микроядра
+static const size_t GEMM_MC = 96;       // 96 x 256 double = 192 КБ (L2)
+static const size_t GEMM_KC = 256;
+static const size_t GEMM_NC = 2048;     // 256 x 2048 double = 4 МБ (L3)
+
+// Столбцов в плитке: 2 вектора AVX2
+template <typename T> struct GemmTile;
+template <> struct GemmTile<double> { static const size_t NR = 8; };
+template <> struct GemmTile<float> { static const size_t NR = 16; };
+
+// Плитка: c[i * ldc + j] += alpha * sum_p ap[p][i] * bp[p][j], i < mr, j < nr
+template <typename T>
+using GemmMicroKernel = void (*)(size_t kc, const T* ap, const T* bp, T alpha,
+                                 T* c, size_t ldc, size_t mr, size_t nr);
+
+template <typename T>
+static void gemm_store(const T acc[GEMM_MR][GemmTile<T>::NR], T alpha,
+                       T* c, size_t ldc, size_t mr, size_t nr) {
+    for (size_t i = 0; i < mr; i++) {
+        for (size_t j = 0; j < nr; j++) {
+            c[i * ldc + j] += alpha * acc[i][j];
+        }
+    }
+}
+
+template <typename T>
+static void gemm_micro_scalar(size_t kc, const T* ap, const T* bp, T alpha,
+                              T* c, size_t ldc, size_t mr, size_t nr) {
+    const size_t NR = GemmTile<T>::NR;
+    T acc[GEMM_MR][NR] = {};
+    for (size_t p = 0; p < kc; p++) {
+        for (size_t i = 0; i < GEMM_MR; i++) {
+            for (size_t j = 0; j < NR; j++) {
+                acc[i][j] += ap[i] * bp[j];
+            }
+        }
+        ap += GEMM_MR;
+        bp += NR;
+    }
+    gemm_store<T>(acc, alpha, c, ldc, mr, nr);
+}
+
+#ifdef MATRIX_SIMD_X86
+__attribute__((target("avx2,fma")))
+static inline matrix_v4d gemm_broadcast(double x) {
+    return matrix_v4d{x, x, x, x};
+}
+
+__attribute__((target("avx2,fma")))
+static inline matrix_v8f gemm_broadcast(float x) {
+    return matrix_v8f{x, x, x, x, x, x, x, x};
+}
+
+// 12 векторных аккумуляторов + 2 вектора B + 1 широковещательный A = 15 регистров ymm
+template <typename T, typename V>
+__attribute__((target("avx2,fma")))
+static void gemm_micro_avx2(size_t kc, const T* ap, const T* bp, T alpha,
+                            T* c, size_t ldc, size_t mr, size_t nr) {
+    const size_t NR = GemmTile<T>::NR;
+    const size_t W = NR / 2;
+    V zero = {};
+    V acc[GEMM_MR][2];
+    for (size_t i = 0; i < GEMM_MR; i++) {
+        acc[i][0] = zero;
+        acc[i][1] = zero;
+    }
+
+    for (size_t p = 0; p < kc; p++) {
+        V b0, b1;
+        std::memcpy(&b0, bp, sizeof(b0));
+        std::memcpy(&b1, bp + W, sizeof(b1));
+#pragma GCC unroll 6
+        for (size_t i = 0; i < GEMM_MR; i++) {
+            V a = gemm_broadcast(ap[i]);
+            acc[i][0] += a * b0;
+            acc[i][1] += a * b1;
+        }
+        ap += GEMM_MR;
+        bp += NR;
+    }
+
+    if (mr == GEMM_MR && nr == NR) {
+        V va = gemm_broadcast(alpha);
+        for (size_t i = 0; i < GEMM_MR; i++) {
+            V c0, c1;
+            std::memcpy(&c0, c + i * ldc, sizeof(c0));
+            std::memcpy(&c1, c + i * ldc + W, sizeof(c1));
+            c0 += va * acc[i][0];
+            c1 += va * acc[i][1];
+            std::memcpy(c + i * ldc, &c0, sizeof(c0));
+            std::memcpy(c + i * ldc + W, &c1, sizeof(c1));
+        }
+        return;
+    }
+
+    T tile[GEMM_MR][NR];
+    std::memcpy(tile, acc, sizeof(tile));
+    gemm_store<T>(tile, alpha, c, ldc, mr, nr);
+}
+#endif
+
+static GemmMicroKernel<double> gemm_micro_kernel(const double*) {
+#ifdef MATRIX_SIMD_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return gemm_micro_avx2<double, matrix_v4d>;
+    }
+#endif
+    return gemm_micro_scalar<double>;
+}
+
+static GemmMicroKernel<float> gemm_micro_kernel(const float*) {
+#ifdef MATRIX_SIMD_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return gemm_micro_avx2<float, matrix_v8f>;
+    }
+#endif
+    return gemm_micro_scalar<float>;
+}
+
+// Панели A: для каждой полосы из MR строк - kc групп по MR элементов (хвост нулями)
+template <typename T>
+static void gemm_pack_a(size_t mc, size_t kc, const T* a, size_t rs, size_t cs, T* ap) {
+    for (size_t i0 = 0; i0 < mc; i0 += GEMM_MR) {
+        size_t mr = std::min(GEMM_MR, mc - i0);
+        for (size_t p = 0; p < kc; p++) {
+            for (size_t i = 0; i < GEMM_MR; i++) {
+                *ap++ = (i < mr) ? a[(i0 + i) * rs + p * cs] : T(0);
+            }
+        }
+    }
+}
+
+// Панели B: для каждой полосы из NR столбцов - kc групп по NR элементов
+template <typename T>
+static void gemm_pack_b(size_t kc, size_t nc, const T* b, size_t rs, size_t cs, T* bp) {
+    const size_t NR = GemmTile<T>::NR;
+    for (size_t j0 = 0; j0 < nc; j0 += NR) {
+        size_t nr = std::min(NR, nc - j0);
+        for (size_t p = 0; p < kc; p++) {
+            for (size_t j = 0; j < NR; j++) {
+                *bp++ = (j < nr) ? b[p * rs + (j0 + j) * cs] : T(0);
+            }
+        }
+    }
+}
+
+// C (m x n, строки через ldc) += alpha * A (m x k) * B (k x n)
+// Блоки строк C раздаются потокам пула; каждый элемент C обновляется одним
+// потоком в фиксированном порядке по p, поэтому результат не зависит от числа потоков.
+template <typename T>
+static void gemm(size_t m, size_t n, size_t k, T alpha,
+                 const T* a, size_t a_rs, size_t a_cs,
+                 const T* b, size_t b_rs, size_t b_cs,
+                 T* c, size_t ldc) {
+    if (m == 0 || n == 0 || k == 0) return;
+
+    const size_t NR = GemmTile<T>::NR;
+    GemmMicroKernel<T> micro = gemm_micro_kernel(a);
+    size_t nc_max = std::min(GEMM_NC, n);
+    std::vector<T> bp(GEMM_KC * ((nc_max + NR - 1) / NR) * NR);
+    size_t blocks = (m + GEMM_MC - 1) / GEMM_MC;
+
+    for (size_t jc = 0; jc < n; jc += GEMM_NC) {
+        size_t nc = std::min(GEMM_NC, n - jc);
+        for (size_t pc = 0; pc < k; pc += GEMM_KC) {
+            size_t kc = std::min(GEMM_KC, k - pc);
+            gemm_pack_b(kc, nc, b + pc * b_rs + jc * b_cs, b_rs, b_cs, bp.data());
+
+            global_thread_pool().parallel_for(blocks, [&](size_t t) {
+                static thread_local std::vector<T> ap;
+                ap.resize(GEMM_MC * GEMM_KC);
+
+                size_t ic = t * GEMM_MC;
+                size_t mc = std::min(GEMM_MC, m - ic);
+                gemm_pack_a(mc, kc, a + ic * a_rs + pc * a_cs, a_rs, a_cs, ap.data());
+
+                for (size_t jr = 0; jr < nc; jr += NR) {
+                    for (size_t ir = 0; ir < mc; ir += GEMM_MR) {
+                        micro(kc, ap.data() + ir * kc, bp.data() + jr * kc, alpha,
+                              c + (ic + ir) * ldc + jc + jr, ldc,
+                              std::min(GEMM_MR, mc - ir), std::min(NR, nc - jr));
+                    }
+                }
+            });
+        }
+    }
+}
+
+// ============ Блочные разложение Холецкого и треугольные решения ============
+
+static const size_t CHOLESKY_BLOCK = 128;
+static const size_t PANEL_ROWS = 4;
+
+// y[0..count) -= x * l[0..count) векторами по 16 байт (SSE2 есть у любого x86-64;
+// при -O2 такой цикл с хвостом сам не векторизуется). Умножение и вычитание
+// раздельные, как в скалярном цикле, поэтому результат тот же
+template <typename T>
+static inline void axpy_sub(T x, const T* l, T* y, size_t count) {
+    typedef T vec __attribute__((vector_size(16)));
+    const size_t W = sizeof(vec) / sizeof(T);
+    size_t q = 0;
+    for (; q + W <= count; q += W) {
+        vec lv, yv;
+        std::memcpy(&lv, l + q, sizeof(vec));
+        std::memcpy(&yv, y + q, sizeof(vec));
+        yv -= x * lv;
+        std::memcpy(y + q, &yv, sizeof(vec));
+    }
+    for (; q < count; q++) {
+        y[q] -= x * l[q];
+    }
+}
+
+// Построчный Холецкий для диагонального блока (n x n, строки через lda)
+template <typename T>
+static void cholesky_unblocked(T* a, size_t lda, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        T* li = a + i * lda;
+        for (size_t j = 0; j <= i; j++) {
+            const T* lj = a + j * lda;
+            T s = li[j];
+            for (size_t k = 0; k < j; k++) {
+                s -= li[k] * lj[k];
+            }
+            if (j < i) {
+                li[j] = s / lj[j];
+            } else if (s > 0) {
+                li[i] = std::sqrt(s);
+            } else {
+                throw std::runtime_error("Матрица не положительно определена, разложение Холецкого невозможно");
+            }
+        }
+    }
+}
+
+// Правосторонний блочный Холецкий: диагональный блок, панель под ним
+// (X L_kk^T = A, построчно), затем обновление хвоста A -= P P^T через gemm
+// только для блочных столбцов нижнего треугольника
+template <typename T>
+static void cholesky_blocked(T* a, size_t lda, size_t n) {
+    std::vector<T> lkt(CHOLESKY_BLOCK * CHOLESKY_BLOCK);   // L_kk^T по строкам
+    for (size_t k0 = 0; k0 < n; k0 += CHOLESKY_BLOCK) {
+        size_t k1 = std::min(k0 + CHOLESKY_BLOCK, n);
+        size_t nb = k1 - k0;
+        const T* lkk = a + k0 * lda + k0;
+
+        cholesky_unblocked(a + k0 * lda + k0, lda, nb);
+        if (k1 == n) break;
+
+        // Панель решается в форме axpy по транспонированному блоку L_kk
+        // (смежные элементы, векторизуется); порядок вычитаний тот же, что
+        // у скалярного произведения, поэтому результат не меняется
+        for (size_t j = 0; j < nb; j++) {
+            for (size_t q = j; q < nb; q++) {
+                lkt[j * CHOLESKY_BLOCK + q] = lkk[q * lda + j];
+            }
+        }
+
+        size_t rows = n - k1;
+        size_t chunks = (rows + CHOLESKY_BLOCK - 1) / CHOLESKY_BLOCK;
+        global_thread_pool().parallel_for(chunks, [&](size_t t) {
+            size_t r0 = k1 + t * CHOLESKY_BLOCK;
+            size_t r1 = std::min(r0 + CHOLESKY_BLOCK, n);
+            // Строки независимы: по PANEL_ROWS строк за проход, чтобы цепочки
+            // деление -> обновление разных строк перекрывались
+            for (size_t i0 = r0; i0 < r1; i0 += PANEL_ROWS) {
+                size_t i1 = std::min(i0 + PANEL_ROWS, r1);
+                for (size_t j = 0; j < nb; j++) {
+                    const T* lj = lkt.data() + j * CHOLESKY_BLOCK;
+                    for (size_t i = i0; i < i1; i++) {
+                        T* row = a + i * lda + k0;
+                        T x = row[j] / lj[j];
+                        row[j] = x;
+                        axpy_sub(x, lj + j + 1, row + j + 1, nb - j - 1);
+                    }
+                }
+            }
+        });
+
+        for (size_t j0 = k1; j0 < n; j0 += CHOLESKY_BLOCK) {
+            size_t j1 = std::min(j0 + CHOLESKY_BLOCK, n);
+            const T* p = a + j0 * lda + k0;
+            gemm<T>(n - j0, j1 - j0, nb, T(-1), p, lda, 1, p, 1, lda, a + j0 * lda + j0, lda);
+        }
+    }
+}
+
+// L Z = B: блок строк B сначала обновляется уже найденными строками Z (gemm),
+// затем решается с диагональным блоком L
+template <typename T>
+static void solve_lower_blocked(const T* l, size_t ldl, size_t n, T* b, size_t ldb, size_t k) {
+    for (size_t i0 = 0; i0 < n; i0 += CHOLESKY_BLOCK) {
+        size_t i1 = std::min(i0 + CHOLESKY_BLOCK, n);
+        gemm<T>(i1 - i0, k, i0, T(-1), l + i0 * ldl, ldl, 1, b, ldb, 1, b + i0 * ldb, ldb);
+
+        for (size_t i = i0; i < i1; i++) {
+            T* bi = b + i * ldb;
+            for (size_t j = i0; j < i; j++) {
+                T lij = l[i * ldl + j];
+                const T* bj = b + j * ldb;
+                for (size_t c = 0; c < k; c++) {
+                    bi[c] -= lij * bj[c];
+                }
+            }
+            for (size_t c = 0; c < k; c++) {
+                bi[c] /= l[i * ldl + i];
+            }
+        }
+    }
+}
+
+// L^T Z = B снизу вверх: блок строк обновляется через (L[i1:n, i0:i1])^T Z[i1:n]
+template <typename T>
+static void solve_lower_trans_blocked(const T* l, size_t ldl, size_t n, T* b, size_t ldb, size_t k) {
+    size_t nblocks = (n + CHOLESKY_BLOCK - 1) / CHOLESKY_BLOCK;
+    for (size_t t = nblocks; t-- > 0;) {
+        size_t i0 = t * CHOLESKY_BLOCK;
+        size_t i1 = std::min(i0 + CHOLESKY_BLOCK, n);
+        gemm<T>(i1 - i0, k, n - i1, T(-1), l + i1 * ldl + i0, 1, ldl, b + i1 * ldb, ldb, 1, b + i0 * ldb, ldb);
+
+        for (size_t i = i1; i-- > i0;) {
+            T* bi = b + i * ldb;
+            for (size_t c = 0; c < k; c++) {
+                bi[c] /= l[i * ldl + i];
+            }
+            for (size_t j = i0; j < i; j++) {
+                T lij = l[i * ldl + j];
+                T* bj = b + j * ldb;
+                for (size_t c = 0; c < k; c++) {
+                    bj[c] -= lij * bi[c];
+                }
+            }
+        }
+    }
+}
+
 /**
  * Создание матрицы заданного размера, инициализированной нулями
  */
@@ -21,17 +503,32 @@ Matrix TransMatrix(const Matrix& a) {
 }
 
 /**
- * Умножение двух матриц через Boost.uBLAS
+ * Умножение двух матриц: блочное ядро или Boost.uBLAS (эталон)
  */
 Matrix MultiplyMatrix(const Matrix& a, const Matrix& b) {
     if (a.size2() != b.size1()) {
         throw std::runtime_error("Несовместимые размеры матриц для умножения");
     }
-    return prod(a, b);
+    if (matrix_backend_requested == MATRIX_BACKEND_UBLAS) {
+        return prod(a, b);
+    }
+
+    Matrix c(a.size1(), b.size2(), 0.0);
+    if (c.size1() == 0 || c.size2() == 0 || a.size2() == 0) return c;
+#ifdef AGAMIROV_LAPACK
+    if (matrix_backend_requested == MATRIX_BACKEND_LAPACK) {
+        lapack_gemm(a.size1(), b.size2(), a.size2(), &a(0, 0), &b(0, 0), &c(0, 0));
+        return c;
+    }
+#endif
+    gemm(a.size1(), b.size2(), a.size2(), 1.0,
+         &a(0, 0), a.size2(), 1, &b(0, 0), b.size2(), 1, &c(0, 0), c.size2());
+    return c;
 }
 
 /**
  * Обращение матрицы методом LU-разложения через Boost.uBLAS
+ * (или dgetrf/dgetri при выборе LAPACK)
  * Более устойчивый численно метод, чем Гаусс-Жордан
  */
 Matrix InverseMatrix(const Matrix& input) {
@@ -45,6 +542,15 @@ Matrix InverseMatrix(const Matrix& input) {
         throw std::runtime_error("Матрица должна быть квадратной для обращения");
     }
 
+#ifdef AGAMIROV_LAPACK
+    // Обратная к транспонированной - транспонированная обратная, поэтому
+    // хранение по строкам не требует перестановки
+    if (matrix_backend_requested == MATRIX_BACKEND_LAPACK && n > 0) {
+        lapack_inverse(&a(0, 0), n);
+        return a;
+    }
+#endif
+
     // Создаем единичную матрицу для результата
     Matrix inverse = identity_matrix<double>(n);
 
@@ -63,6 +569,391 @@ Matrix InverseMatrix(const Matrix& input) {
     return inverse;
 }
 
+/**
+ * Разложение Холецкого: блочное (основной путь) или построчное
+ * (Холецкий-Банахевич, эталон - в uBLAS разложения Холецкого нет)
+ */
+template <typename T>
+static void cholesky_decompose(ublas::matrix<T>& a) {
+    size_t n = a.size1();
+    if (n != a.size2()) {
+        throw std::runtime_error("Матрица должна быть квадратной для разложения Холецкого");
+    }
+    if (n == 0) return;
+
+    if (matrix_backend_requested == MATRIX_BACKEND_UBLAS) {
+        cholesky_unblocked(&a(0, 0), n, n);
+#ifdef AGAMIROV_LAPACK
+    } else if (matrix_backend_requested == MATRIX_BACKEND_LAPACK) {
+        lapack_cholesky(&a(0, 0), n);
+#endif
+    } else {
+        cholesky_blocked(&a(0, 0), n, n);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+            a(i, j) = T(0);
+        }
+    }
+}
+
+/**
+ * Прямая подстановка L Z = B для всех столбцов сразу
+ */
+template <typename T>
+static void solve_lower(const ublas::matrix<T>& l, ublas::matrix<T>& b) {
+    size_t n = l.size1();
+    if (b.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для треугольного решения");
+    }
+    if (n == 0 || b.size2() == 0) return;
+
+    if (matrix_backend_requested == MATRIX_BACKEND_UBLAS) {
+        inplace_solve(l, b, lower_tag());
+#ifdef AGAMIROV_LAPACK
+    } else if (matrix_backend_requested == MATRIX_BACKEND_LAPACK) {
+        lapack_solve_lower("N", &l(0, 0), n, &b(0, 0), b.size2());
+#endif
+    } else {
+        solve_lower_blocked(&l(0, 0), n, n, &b(0, 0), b.size2(), b.size2());
+    }
+}
+
+/**
+ * Обратная подстановка с L^T: транспонированный множитель берется шагами по столбцу
+ */
+template <typename T>
+static void solve_lower_trans(const ublas::matrix<T>& l, ublas::matrix<T>& b) {
+    size_t n = l.size1();
+    if (b.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для треугольного решения");
+    }
+    if (n == 0 || b.size2() == 0) return;
+
+    if (matrix_backend_requested == MATRIX_BACKEND_UBLAS) {
+        inplace_solve(trans(l), b, upper_tag());
+#ifdef AGAMIROV_LAPACK
+    } else if (matrix_backend_requested == MATRIX_BACKEND_LAPACK) {
+        lapack_solve_lower("T", &l(0, 0), n, &b(0, 0), b.size2());
+#endif
+    } else {
+        solve_lower_trans_blocked(&l(0, 0), n, n, &b(0, 0), b.size2(), b.size2());
+    }
+}
+
+void CholeskyDecompose(Matrix& a) {
+    cholesky_decompose(a);
+}
+
+void SolveLower(const Matrix& l, Matrix& b) {
+    solve_lower(l, b);
+}
+
+void SolveLowerTrans(const Matrix& l, Matrix& b) {
+    solve_lower_trans(l, b);
+}
+
+void CholeskyDecompose(MatrixFloat& a) {
+    cholesky_decompose(a);
+}
+
+void SolveLower(const MatrixFloat& l, MatrixFloat& b) {
+    solve_lower(l, b);
+}
+
+void SolveLowerTrans(const MatrixFloat& l, MatrixFloat& b) {
+    solve_lower_trans(l, b);
+}
+
+// ============ Смешанная точность ============
+
+// Максимум модуля в каждом столбце (n x k по строкам)
+static void column_norms_inf(const Matrix& a, std::vector<double>& norms) {
+    norms.assign(a.size2(), 0.0);
+    for (size_t i = 0; i < a.size1(); i++) {
+        for (size_t j = 0; j < a.size2(); j++) {
+            norms[j] = std::max(norms[j], std::fabs(a(i, j)));
+        }
+    }
+}
+
+// V Z = B полностью в double (запасной путь)
+static void cholesky_solve_double(const Matrix& v, Matrix& b) {
+    Matrix l(v);
+    CholeskyDecompose(l);
+    SolveLower(l, b);
+    SolveLowerTrans(l, b);
+}
+
+void CholeskySolveMixed(const Matrix& v, Matrix& b, RefinementReport* report) {
+    size_t n = v.size1();
+    size_t k = b.size2();
+    if (n != v.size2() || b.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для решения системы");
+    }
+
+    RefinementReport local;
+    RefinementReport& rep = report ? *report : local;
+    rep = RefinementReport();
+    if (n == 0 || k == 0) return;
+
+    // Копия во float и ||V||_inf (максимум суммы модулей по строкам) за один проход;
+    // четыре частичные суммы, чтобы сложения не ждали друг друга
+    MatrixFloat lf(n, n);
+    double vnorm = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        const double* vi = &v(i, 0);
+        float* fi = &lf(i, 0);
+        double sum[4] = {0.0, 0.0, 0.0, 0.0};
+        size_t j = 0;
+        for (; j + 4 <= n; j += 4) {
+            for (size_t t = 0; t < 4; t++) {
+                fi[j + t] = float(vi[j + t]);
+                sum[t] += std::fabs(vi[j + t]);
+            }
+        }
+        for (; j < n; j++) {
+            fi[j] = float(vi[j]);
+            sum[0] += std::fabs(vi[j]);
+        }
+        vnorm = std::max(vnorm, (sum[0] + sum[1]) + (sum[2] + sum[3]));
+    }
+    const double tolerance = std::sqrt(double(n)) * std::numeric_limits<double>::epsilon() * vnorm;
+
+    // r = B - V Z в double; возвращает max по столбцам ||r|| / (||V|| ||z||)
+    Matrix r(b);
+    std::vector<double> rnorm, znorm;
+    bool converged = false;
+    auto residual = [&](const Matrix& z) {
+        r = b - MultiplyMatrix(v, z);
+        column_norms_inf(r, rnorm);
+        column_norms_inf(z, znorm);
+        converged = true;
+        double worst = 0.0;
+        for (size_t j = 0; j < k; j++) {
+            if (rnorm[j] > tolerance * znorm[j]) converged = false;
+            if (rnorm[j] > 0.0) {
+                worst = std::max(worst, rnorm[j] / (vnorm * znorm[j]));
+            }
+        }
+        return worst;
+    };
+
+    Matrix z(n, k, 0.0);
+    bool factored = true;
+    try {
+        CholeskyDecompose(lf);
+    } catch (const std::runtime_error&) {
+        // Во float матрица перестала быть положительно определенной
+        factored = false;
+    }
+
+    MatrixFloat d(n, k);
+    double previous = std::numeric_limits<double>::infinity();
+    for (int step = 0; factored; step++) {
+        // Поправка во float: V_f d = r
+        std::copy(r.data().begin(), r.data().end(), d.data().begin());
+        SolveLower(lf, d);
+        SolveLowerTrans(lf, d);
+        for (size_t i = 0; i < n * k; i++) {
+            z.data()[i] += d.data()[i];
+        }
+
+        double worst = residual(z);
+        rep.steps = step;
+        rep.residual = worst;
+        if (converged) {
+            b = z;
+            return;
+        }
+
+        // Уточнение сходится со скоростью ~ cond(V) eps_float: если невязка
+        // не убывает хотя бы вдвое, V для float слишком плохо обусловлена
+        if (step == MIXED_REFINEMENT_MAX || (step > 0 && worst > 0.5 * previous)) break;
+        previous = worst;
+    }
+
+    // Запасной путь: разложение в double; в отчете - невязка итогового решения
+    rep.fallback = true;
+    z = b;
+    cholesky_solve_double(v, z);
+    rep.residual = residual(z);
+    b = z;
+}
+
+// ============ Упакованные симметричные матрицы ============
+// Хранится верхний треугольник по строкам: u_i[j] = A(i, j) при j >= i,
+// где u_i = data + packed_row_offset(n, i) - i. Все внутренние циклы -
+// проходы по смежным элементам строки (axpy или скалярное произведение).
+
+static const size_t PACKED_BLOCK = 32;   // строк L^T в блоке обновления хвоста
+
+static inline double* packed_row(double* data, size_t n, size_t i) {
+    return data + packed_row_offset(n, i) - i;
+}
+
+static inline const double* packed_row(const double* data, size_t n, size_t i) {
+    return data + packed_row_offset(n, i) - i;
+}
+
+Matrix MultiplyMatrix(const SymmetricMatrix& a, const Matrix& b) {
+    size_t n = a.size1();
+    size_t k = b.size2();
+    if (b.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для умножения");
+    }
+
+    Matrix c(n, k, 0.0);
+    if (n == 0 || k == 0) return c;
+    const double* data = &a.data()[0];
+
+    // Строка i дает вклад в c_i (элементы j >= i) и, по симметрии, в c_j (j > i)
+    for (size_t i = 0; i < n; i++) {
+        const double* ai = packed_row(data, n, i);
+        const double* bi = &b(i, 0);
+        double* ci = &c(i, 0);
+        for (size_t q = 0; q < k; q++) {
+            ci[q] += ai[i] * bi[q];
+        }
+        for (size_t j = i + 1; j < n; j++) {
+            const double* bj = &b(j, 0);
+            double* cj = &c(j, 0);
+            for (size_t q = 0; q < k; q++) {
+                ci[q] += ai[j] * bj[q];
+                cj[q] += ai[j] * bi[q];
+            }
+        }
+    }
+    return c;
+}
+
+// Правосторонний Холецкий в форме A = U^T U, U = L^T: строка k делится на U(k,k),
+// затем из строк i > k вычитается U(k,i) * (строка k). Строки блока [k0, k1)
+// обновляют друг друга сразу, а хвост - одним проходом на блок (параллельно по строкам).
+void CholeskyDecomposePacked(double* data, size_t n) {
+#ifdef AGAMIROV_LAPACK
+    if (matrix_backend_requested == MATRIX_BACKEND_LAPACK) {
+        if (n > 0) lapack_cholesky_packed(data, n);
+        return;
+    }
+#endif
+    for (size_t k0 = 0; k0 < n; k0 += PACKED_BLOCK) {
+        size_t k1 = std::min(k0 + PACKED_BLOCK, n);
+
+        for (size_t k = k0; k < k1; k++) {
+            double* uk = packed_row(data, n, k);
+            if (!(uk[k] > 0.0)) {
+                throw std::runtime_error("Матрица не положительно определена, разложение Холецкого невозможно");
+            }
+            double ukk = std::sqrt(uk[k]);
+            uk[k] = ukk;
+            for (size_t j = k + 1; j < n; j++) {
+                uk[j] /= ukk;
+            }
+            for (size_t i = k + 1; i < k1; i++) {
+                double* ui = packed_row(data, n, i);
+                double c = uk[i];
+                for (size_t j = i; j < n; j++) {
+                    ui[j] -= c * uk[j];
+                }
+            }
+        }
+        if (k1 == n) break;
+
+        size_t rows = n - k1;
+        size_t chunks = (rows + PACKED_BLOCK - 1) / PACKED_BLOCK;
+        auto update = [&](size_t t) {
+            size_t r0 = k1 + t * PACKED_BLOCK;
+            size_t r1 = std::min(r0 + PACKED_BLOCK, n);
+            for (size_t i = r0; i < r1; i++) {
+                double* ui = packed_row(data, n, i);
+                for (size_t k = k0; k < k1; k++) {
+                    const double* uk = packed_row(data, n, k);
+                    double c = uk[i];
+                    for (size_t j = i; j < n; j++) {
+                        ui[j] -= c * uk[j];
+                    }
+                }
+            }
+        };
+        // Тело передается по ссылке: std::function хранит ее без выделения памяти
+        global_thread_pool().parallel_for(chunks, [&update](size_t t) { update(t); });
+    }
+}
+
+void CholeskyDecompose(SymmetricMatrix& a) {
+    size_t n = a.size1();
+    if (n == 0) return;
+    CholeskyDecomposePacked(&a.data()[0], n);
+}
+
+// L Z = B, L = U^T: столбец k матрицы L - строка k матрицы U
+void SolveLowerPacked(const double* data, size_t n, double* b, size_t k) {
+#ifdef AGAMIROV_LAPACK
+    if (matrix_backend_requested == MATRIX_BACKEND_LAPACK) {
+        if (n > 0) lapack_solve_lower_packed("N", data, n, b, k);
+        return;
+    }
+#endif
+    for (size_t r = 0; r < n; r++) {
+        const double* ur = packed_row(data, n, r);
+        double* br = b + r * k;
+        for (size_t q = 0; q < k; q++) {
+            br[q] /= ur[r];
+        }
+        for (size_t j = r + 1; j < n; j++) {
+            double* bj = b + j * k;
+            for (size_t q = 0; q < k; q++) {
+                bj[q] -= ur[j] * br[q];
+            }
+        }
+    }
+}
+
+void SolveLower(const SymmetricMatrix& l, Matrix& b) {
+    size_t n = l.size1();
+    size_t k = b.size2();
+    if (b.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для треугольного решения");
+    }
+    if (n == 0 || k == 0) return;
+    SolveLowerPacked(&l.data()[0], n, &b(0, 0), k);
+}
+
+// L^T Z = B, L^T = U: обратная подстановка по строкам U
+void SolveLowerTransPacked(const double* data, size_t n, double* b, size_t k) {
+#ifdef AGAMIROV_LAPACK
+    if (matrix_backend_requested == MATRIX_BACKEND_LAPACK) {
+        if (n > 0) lapack_solve_lower_packed("T", data, n, b, k);
+        return;
+    }
+#endif
+    for (size_t r = n; r-- > 0;) {
+        const double* ur = packed_row(data, n, r);
+        double* br = b + r * k;
+        for (size_t j = r + 1; j < n; j++) {
+            const double* bj = b + j * k;
+            for (size_t q = 0; q < k; q++) {
+                br[q] -= ur[j] * bj[q];
+            }
+        }
+        for (size_t q = 0; q < k; q++) {
+            br[q] /= ur[r];
+        }
+    }
+}
+
+void SolveLowerTrans(const SymmetricMatrix& l, Matrix& b) {
+    size_t n = l.size1();
+    size_t k = b.size2();
+    if (b.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для треугольного решения");
+    }
+    if (n == 0 || k == 0) return;
+    SolveLowerTransPacked(&l.data()[0], n, &b(0, 0), k);
+}
+
 /**
  * Вывод матрицы на экран
  */
@@ -3,67 +3,181 @@
 #include "nelder_mead.h"
 #include "matrix_operations.h"
 #include "order.h"
+#include "order_cache.h"
+#include "root_solver.h"
+#include "thread_pool.h"
+#include "trust_region.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <numeric>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 // ============ Целевая функция для нормального распределения ============
 // Реализация из boost.cpp файла
-double NormalMinFunction(std::vector<double> xsimpl) {
+// Данные - из контекста ctx, параметры (μ, σ) - значениями
+static double normal_min_value(const FitContext& ctx, double a, double s) {
     double s1, s2, s3, s4, z, psi, p, d, c1, c2;
-    int i, kx;
+    int i, kx, r;
     s1 = 0; s2 = 0; s3 = 0; s4 = 0; kx = 0;
     
-    if (xsimpl[0] <= 0) return 10000;
-    if (xsimpl[1] <= 0) return 10000;
+    if (a <= 0) return 10000;
+    if (s <= 0) return 10000;
 
-    for (i = 0; i < nesm.n; i++) {
-        z = (nesm.x[i] - xsimpl[0]) / xsimpl[1];
+    for (i = 0; i < ctx.n; i++) {
+        r = ctx.censored(i);
+        z = (ctx.x[i] - a) / s;
         d = norm_pdf(z);
         p = norm_cdf(z);
         psi = d / (1. - p);
-        s1 += (1. - nesm.r[i]) * (nesm.x[i] - xsimpl[0]);
-        s2 += (1. - nesm.r[i]) * pow(nesm.x[i] - xsimpl[0], 2);
-        s3 += nesm.r[i] * psi;
-        s4 += nesm.r[i] * psi * z;
-        kx += 1 - nesm.r[i];
-    }
-    c1 = s1 + xsimpl[1] * s3;
-    c2 = s2 + pow(xsimpl[1], 2) * (s4 - kx);
+        s1 += (1. - r) * (ctx.x[i] - a);
+        s2 += (1. - r) * pow(ctx.x[i] - a, 2);
+        s3 += r * psi;
+        s4 += r * psi * z;
+        kx += 1 - r;
+    }
+    c1 = s1 + s * s3;
+    c2 = s2 + pow(s, 2) * (s4 - kx);
     z = c1 * c1 + c2 * c2;
     return z;
 }
 
+double NormalMinFunction(std::vector<double> xsimpl) {
+    return normal_min_value(FitContext(nesm), xsimpl[0], xsimpl[1]);
+}
+
+double NormalMinValue(const FitContext& ctx, const std::array<double, 2>& xsimpl) {
+    return normal_min_value(ctx, xsimpl[0], xsimpl[1]);
+}
+
 // ============ Целевая функция для распределения Вейбулла ============
 // Реализация из boost.cpp файла
-double WeibullMinFunction(std::vector<double> xsimpl) {
-    double s1, s2, s3, z, b, c;
+static double weibull_min_value(const FitContext& ctx, double b) {
+    double s1, s2, s3, z, c;
     int i, k;
     
-    if (xsimpl[0] <= 0) return 10000000.;
+    if (b <= 0) return 10000000.;
     s1 = 0; s2 = 0; s3 = 0; k = 0;
-    b = xsimpl[0];
     
-    for (i = 0; i < nesm.n; i++) {
-        k += (1 - nesm.r[i]);
-        s1 += pow(nesm.x[i], b);
+    for (i = 0; i < ctx.n; i++) {
+        k += (1 - ctx.censored(i));
+        s1 += pow(ctx.x[i], b);
     }
     c = s1 / k;
 
-    for (i = 0; i < nesm.n; i++) {
-        z = (pow(nesm.x[i], b)) / c;
+    for (i = 0; i < ctx.n; i++) {
+        z = (pow(ctx.x[i], b)) / c;
         s3 += z * log(z);
-        s2 += (1 - nesm.r[i]) * log(z);
+        s2 += (1 - ctx.censored(i)) * log(z);
     }
     c = s3 - s2 - k;
     return c * c;
 }
 
+// ============ Параметр формы Вейбулла: профильное уравнение правдоподобия ============
+// После исключения масштаба (c = Σ x^b / k, k - число отказов) уравнение правдоподобия
+// по форме b: h(b) = Σ x^b ln x / Σ x^b - 1/b - Σ_{r=0} ln x / k = 0 - то же уравнение,
+// что в weibull_min_value, деленное на k b. h возрастает (h' = Var_w(ln x) + 1/b² > 0),
+// поэтому корень единственный. Веса x^b = exp(b (ln x - ln x_max)) не переполняются,
+// за проход - одна exp на наблюдение, h и h' вычисляются вместе
+RootResult weibull_shape_mle(const FitContext& ctx, double b0) {
+    std::vector<double> logs(ctx.n);
+    double log_max = -std::numeric_limits<double>::infinity();
+    double log_sum = 0.0;
+    int k = 0;
+    for (int i = 0; i < ctx.n; i++) {
+        if (!(ctx.x[i] > 0.0)) {
+            throw std::runtime_error("MLE распределения Вейбулла: наблюдения должны быть положительными");
+        }
+        logs[i] = std::log(ctx.x[i]);
+        log_max = std::max(log_max, logs[i]);
+        if (ctx.censored(i) == 0) {
+            log_sum += logs[i];
+            k++;
+        }
+    }
+    if (k == 0) {
+        throw std::runtime_error("MLE распределения Вейбулла: нет полных наблюдений");
+    }
+
+    auto profile = [&](double b, double& derivative) {
+        double s = 0.0, t = 0.0, u = 0.0;
+        for (int i = 0; i < ctx.n; i++) {
+            double l = logs[i] - log_max;
+            double w = std::exp(b * l);
+            s += w;
+            t += w * l;
+            u += w * l * l;
+        }
+        double mean = t / s;
+        derivative = u / s - mean * mean + 1.0 / (b * b);
+        return mean + log_max - 1.0 / b - log_sum / k;
+    };
+
+    // Отделение корня от b0 удвоением (h(b0) < 0) или делением пополам,
+    // начальное приближение - шаг Ньютона из последней точки
+    int evaluations = 1;
+    double d;
+    double b = b0;
+    double h = profile(b, d);
+    double neg = b, pos = b;
+    bool have_neg = h < 0.0, have_pos = h > 0.0;
+    const int max_bracket = 64;
+    while (!(have_neg && have_pos) && h != 0.0 && std::isfinite(h) && evaluations < max_bracket) {
+        // Шаг Ньютона, удлиненный вдвое, чтобы перейти через корень, но не дальше
+        // чем в 8 раз от b (h возрастает, знак шага определяется знаком h)
+        double next = b - 2.0 * h / d;
+        b = std::min(std::max(next, b / 8.0), 8.0 * b);
+        h = profile(b, d);
+        evaluations++;
+        if (h < 0.0) {
+            neg = b;
+            have_neg = true;
+        } else if (h > 0.0) {
+            pos = b;
+            have_pos = true;
+        }
+    }
+    if (h == 0.0) {
+        RootResult root;
+        root.root = b;
+        root.evaluations = evaluations;
+        root.converged = true;
+        return root;
+    }
+    if (!(have_neg && have_pos)) {
+        // Все полные наблюдения на x_max (h > 0 недостижимо) или h не вычисляется
+        throw std::runtime_error("MLE распределения Вейбулла: не удалось отделить корень для формы");
+    }
+
+    RootResult root = newton_bracketed(neg, pos, b - h / d, profile);
+    root.evaluations += evaluations;
+    return root;
+}
+
+double WeibullMinFunction(std::vector<double> xsimpl) {
+    return weibull_min_value(FitContext(nesm), xsimpl[0]);
+}
+
+double WeibullMinValue(const FitContext& ctx, const std::array<double, 1>& xsimpl) {
+    return weibull_min_value(ctx, xsimpl[0]);
+}
+
 // ============ Ковариационная матрица для нормального распределения ============
 // Реализация из boost.cpp файла
-void CovMatrixMleN(int n, std::vector<double> x, std::vector<int> r, double a, double s, double**& v) {
+Mat2 CovMatrixMleN(int n, const std::vector<double>& x, const std::vector<int>& r, double a, double s) {
     double z, p, d, s1, s2, s3, psi;
     int j, k;
     s1 = 0; s2 = 0; s3 = 0; k = 0;
@@ -79,90 +193,106 @@ void CovMatrixMleN(int n, std::vector<double> x, std::vector<int> r, double a, d
         k += (1 - r[j]);
     }
 
-    v[0][0] = (k + s1) / n; v[0][1] = s3 / n;
-    v[1][0] = s3 / n; v[1][1] = (2 * k + s2) / n;
-
-    // Обращение через Boost.uBLAS
-    Matrix v_matrix(2, 2);
-    v_matrix(0, 0) = v[0][0]; v_matrix(0, 1) = v[0][1];
-    v_matrix(1, 0) = v[1][0]; v_matrix(1, 1) = v[1][1];
-    Matrix v_inv = InverseMatrix(v_matrix);
-    v[0][0] = v_inv(0, 0); v[0][1] = v_inv(0, 1);
-    v[1][0] = v_inv(1, 0); v[1][1] = v_inv(1, 1);
+    Mat2 v;
+    v(0, 0) = (k + s1) / n; v(0, 1) = s3 / n;
+    v(1, 0) = s3 / n; v(1, 1) = (2 * k + s2) / n;
+    return inverse(v);
 }
 
 // ============ Ковариационная матрица для распределения Вейбулла ============
 // Реализация из boost.cpp файла
-void CovMatrixMleW(int n, std::vector<double> x, std::vector<int> r, double c, double b, double**& v) {
+Mat2 CovMatrixMleW(int n, const std::vector<double>& x, const std::vector<int>& r, double c, double b) {
     int i, k;
     double s1, s2, z, cpw, ckow;
     cpw = log(c); ckow = 1 / b; s1 = 0; s2 = 0; k = 0;
-    
+
     for (i = 0; i < n; i++) {
         z = (log(x[i]) - cpw) / ckow;
         s1 += (1 - r[i]) * z;
         s2 += z * z * exp(z);
         k += (1 - r[i]);
     }
-    v[0][0] = double(k) / double(n);
-    v[0][1] = (k + s1) / n;
-    v[1][0] = (k + s1) / n;
-    v[1][1] = (k + s2) / n;
 
-    // Обращение через Boost.uBLAS
-    Matrix v_matrix(2, 2);
-    v_matrix(0, 0) = v[0][0]; v_matrix(0, 1) = v[0][1];
-    v_matrix(1, 0) = v[1][0]; v_matrix(1, 1) = v[1][1];
-    Matrix v_inv = InverseMatrix(v_matrix);
-    v[0][0] = v_inv(0, 0); v[0][1] = v_inv(0, 1);
-    v[1][0] = v_inv(1, 0); v[1][1] = v_inv(1, 1);
+    Mat2 v;
+    v(0, 0) = double(k) / double(n);
+    v(0, 1) = (k + s1) / n;
+    v(1, 0) = (k + s1) / n;
+    v(1, 1) = (k + s2) / n;
+    return inverse(v);
 }
 
-// ============ MLE для нормального распределения (полные данные) ============
-MLEResult mle_normal_complete(const std::vector<double>& data) {
-    MLEResult result;
+// Старый интерфейс: результат в заранее выделенный массив строк v[2][2]
+static void copy_covariance(const Mat2& cov, double** v) {
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            v[i][j] = cov(i, j);
+        }
+    }
+}
+
+void CovMatrixMleN(int n, const std::vector<double>& x, const std::vector<int>& r, double a, double s,
+                   double**& v) {
+    copy_covariance(CovMatrixMleN(n, x, r, a, s), v);
+}
+
+void CovMatrixMleW(int n, const std::vector<double>& x, const std::vector<int>& r, double c, double b,
+                   double**& v) {
+    copy_covariance(CovMatrixMleW(n, x, r, c, b), v);
+}
+
+// Ковариация параметров в результате и стандартные ошибки по ее диагонали
+static void store_covariance(MLEResult& result, CovarianceMatrix cov) {
+    result.std_errors.resize(cov.size());
+    for (size_t i = 0; i < cov.size(); i++) {
+        result.std_errors[i] = std::sqrt(std::abs(cov(i, i)));
+    }
+    result.covariance = std::move(cov);
+}
+
+// ============ Выборочные моменты нормальной выборки ============
+// Среднее, смещенная дисперсия (MLE) и логарифм правдоподобия при них
+static void normal_sample_moments(const std::vector<double>& data, double& mean, double& variance,
+                                  double& log_likelihood) {
     int n = data.size();
-    
-    // Вычисление среднего
-    double mean = std::accumulate(data.begin(), data.end(), 0.0) / n;
-    
-    // Вычисление стандартного отклонения
-    double variance = 0.0;
+    mean = std::accumulate(data.begin(), data.end(), 0.0) / n;
+
+    variance = 0.0;
     for (double x : data) {
         variance += (x - mean) * (x - mean);
     }
     variance /= n;
     double std = std::sqrt(variance);
-    
-    // Начальные параметры (для нормального распределения совпадают с финальными,
-    // т.к. есть аналитическое решение)
-    result.initial_parameters = {mean, std};
 
-    // Начальный log-likelihood
-    result.initial_log_likelihood = 0.0;
+    log_likelihood = 0.0;
     for (double x : data) {
         double z = (x - mean) / std;
-        result.initial_log_likelihood += -0.5 * log(2 * M_PI) - log(std) - 0.5 * z * z;
+        log_likelihood += -0.5 * log(2 * M_PI) - log(std) - 0.5 * z * z;
     }
+}
+
+// ============ MLE для нормального распределения (полные данные) ============
+MLEResult mle_normal_complete(const std::vector<double>& data) {
+    MLEResult result;
+    int n = data.size();
+
+    // Среднее, стандартное отклонение и начальный log-likelihood
+    double mean, variance;
+    normal_sample_moments(data, mean, variance, result.initial_log_likelihood);
+    double std = std::sqrt(variance);
+
+    // Начальные параметры (для нормального распределения совпадают с финальными,
+    // т.к. есть аналитическое решение)
+    result.initial_parameters = {mean, std};
 
     result.parameters = {mean, std};
     result.iterations = 0;
     result.converged = true;
-    result.cov_size = 2;
 
-    // Ковариационная матрица (асимптотическая) - используем обычный массив для совместимости
-    result.covariance = new double*[2];
-    for (int i = 0; i < 2; i++) {
-        result.covariance[i] = new double[2]();
-    }
-    result.covariance[0][0] = variance / n;
-    result.covariance[0][1] = 0.0;
-    result.covariance[1][0] = 0.0;
-    result.covariance[1][1] = variance / (2.0 * n);
-
-    // Стандартные ошибки
-    result.std_errors = {std::sqrt(result.covariance[0][0]),
-                        std::sqrt(result.covariance[1][1])};
+    // Ковариационная матрица (асимптотическая) и стандартные ошибки
+    Mat2 cov;
+    cov(0, 0) = variance / n;
+    cov(1, 1) = variance / (2.0 * n);
+    store_covariance(result, cov);
 
     // Вычисление логарифма функции правдоподобия
     result.log_likelihood = result.initial_log_likelihood;
@@ -170,76 +300,334 @@ MLEResult mle_normal_complete(const std::vector<double>& data) {
     return result;
 }
 
-// ============ MLS для нормального распределения (ТОЛЬКО полные данные) ============
-// Использует взвешенный МНК через порядковые статистики Агамирова (ordern)
-MLEResult mls_normal_complete(const std::vector<double>& data) {
+// ============ MLE для нормального распределения (цензурированные данные) ============
+// -log L по (μ, σ) с градиентом и гессианом за один проход по данным.
+// Полное наблюдение: log L_i = -log σ - z²/2 - log √(2π), z = (x_i - μ)/σ;
+// цензурированное справа: log L_i = log Q(z), Q = 1 - Φ, d log Q/dz = -ψ,
+// ψ = φ(z)/Q(z) - интенсивность, dψ/dz = ψ(ψ - z) (те же ψ и z, что в CovMatrixMleN)
+static double normal_censored_nll(const FitContext& ctx, const std::array<double, 2>& x,
+                                  std::array<double, 2>& g, Mat2& h) {
+    double a = x[0], s = x[1];
+    if (!(s > 0.0)) return std::numeric_limits<double>::infinity();
+
+    double f = 0.0;
+    double ga = 0.0, gs = 0.0, haa = 0.0, has = 0.0, hss = 0.0;
+    int k = 0;
+    for (int i = 0; i < ctx.n; i++) {
+        double z = (ctx.x[i] - a) / s;
+        if (ctx.censored(i) == 0) {
+            f += 0.5 * z * z;
+            ga -= z;
+            gs -= z * z;
+            haa += 1.0;
+            has += 2.0 * z;
+            hss += 3.0 * z * z;
+            k++;
+        } else {
+            double q = 0.5 * std::erfc(z / std::sqrt(2.0));
+            if (!(q > 0.0)) return std::numeric_limits<double>::infinity();
+            double psi = norm_pdf(z) / q;
+            double dpsi = psi * (psi - z);
+            f -= std::log(q);
+            ga -= psi;
+            gs -= psi * z;
+            haa += dpsi;
+            has += dpsi * z + psi;
+            hss += dpsi * z * z + 2.0 * psi * z;
+        }
+    }
+    f += k * (std::log(s) + 0.5 * std::log(2.0 * M_PI));
+
+    // Производные по z собраны без множителей 1/σ и 1/σ²
+    g[0] = ga / s;
+    g[1] = (gs + k) / s;
+    h(0, 0) = haa / (s * s);
+    h(0, 1) = h(1, 0) = has / (s * s);
+    h(1, 1) = (hss - k) / (s * s);
+    return f;
+}
+
+MLEResult mle_normal_censored(const std::vector<double>& data, const std::vector<int>& censored) {
     MLEResult result;
-    int n = data.size();
+    FitContext ctx(data, censored);
+
+    // Начальные оценки по полным наблюдениям
+    double sum = 0.0;
+    int n_complete = 0;
+    for (int i = 0; i < ctx.n; i++) {
+        if (ctx.censored(i) == 0) {
+            sum += data[i];
+            n_complete++;
+        }
+    }
+    if (n_complete < 2) {
+        throw std::runtime_error("MLE нормального распределения: нужно хотя бы два полных наблюдения");
+    }
+    double mean_init = sum / n_complete;
+    double variance_init = 0.0;
+    for (int i = 0; i < ctx.n; i++) {
+        if (ctx.censored(i) == 0) {
+            variance_init += (data[i] - mean_init) * (data[i] - mean_init);
+        }
+    }
+    variance_init /= n_complete;
+    if (variance_init == 0.0) {
+        // Полные наблюдения совпадают: начальный разброс - по всей выборке
+        for (int i = 0; i < ctx.n; i++) variance_init += (data[i] - mean_init) * (data[i] - mean_init);
+        variance_init /= ctx.n;
+        if (variance_init == 0.0) {
+            throw std::runtime_error("MLE нормального распределения: все наблюдения совпадают");
+        }
+    }
+    std::array<double, 2> x0 = {mean_init, std::sqrt(variance_init)};
 
-    // Начальная оценка - используем MLE
-    MLEResult initial_mle = mle_normal_complete(data);
-    result.initial_parameters = initial_mle.parameters;
-    result.initial_log_likelihood = initial_mle.log_likelihood;
+    // Слишком малая σ (близкие полные наблюдения) дает Q(z) = 0 для цензурированных -
+    // разброс увеличивается, пока правдоподобие не станет конечным
+    std::array<double, 2> g;
+    Mat2 h;
+    double f0 = normal_censored_nll(ctx, x0, g, h);
+    for (int k = 0; k < 64 && !std::isfinite(f0); k++) {
+        x0[1] *= 2.0;
+        f0 = normal_censored_nll(ctx, x0, g, h);
+    }
+    if (!std::isfinite(f0)) {
+        throw std::runtime_error("MLE нормального распределения: не найдено начальное приближение");
+    }
+    result.initial_parameters = {x0[0], x0[1]};
+    result.initial_log_likelihood = -f0;
 
-    // Подготовка данных: все данные полные (r[i] = 0)
-    std::vector<int> r(n, 0);  // все наблюдения полные
-    std::vector<double> fcum(n);
-    std::vector<double> ycum(n);
+    TrustRegionResult<2> tr = newton_trust_region(x0, TrustRegionOptions(),
+        [&ctx](const std::array<double, 2>& x, std::array<double, 2>& g, Mat2& h) {
+            return normal_censored_nll(ctx, x, g, h);
+        });
 
-    // Вычисление эмпирической функции распределения
-    cum(n, data, r, n, fcum, ycum);
+    result.parameters = {tr.parameters[0], tr.parameters[1]};
+    result.log_likelihood = -tr.final_value;
+    result.iterations = tr.iterations;
+    result.converged = tr.converged;
 
-    // Построение ковариационной матрицы порядковых статистик через Boost.uBLAS
-    Matrix v = createMatrix(n, n);
-    Matrix x = createMatrix(n, 2);
-    Matrix y = createMatrix(n, 1);
-    Matrix b = createMatrix(2, 1);
-    Matrix db = createMatrix(2, 2);
-    Vector yr(n);
+    // Гессиан -log L в точке оценки - наблюдаемая информация, ковариация - ее обращение
+    store_covariance(result, inverse(tr.hessian));
+    return result;
+}
 
-    // Заполнение матриц для взвешенного МНК
-    for (int i = 0; i < n; i++) {
-        for (int j = i; j < n; j++) {
-            double er_i, vrs;
-            ordern(n, fcum[i], fcum[j], er_i, vrs);
-            v(j, i) = vrs;
-            v(i, j) = vrs;
+// Начиная с этого размера выборки MLS использует структурированную ковариацию
+// (O(n) памяти) вместо плотной матрицы n x n и ее обращения за O(n^3)
+static const int MLS_STRUCTURED_MIN_N = 200;
+
+// ============ Бюджет памяти MLS ============
+
+static bool mls_budget_requested = false;
+static size_t mls_budget_bytes = 0;
+
+// Половина физической памяти; 0 (без ограничения), если ее не узнать
+static size_t mls_default_budget() {
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0) {
+        return size_t(pages) / 2 * size_t(page_size);
+    }
+#endif
+    return 0;
+}
+
+void mls_set_memory_budget(size_t bytes) {
+    mls_budget_bytes = bytes;
+    mls_budget_requested = true;
+}
+
+size_t mls_memory_budget() {
+    if (mls_budget_requested) return mls_budget_bytes;
+    static const size_t default_budget = mls_default_budget();
+    return default_budget;
+}
+
+size_t mls_strategy_memory(MlsStrategy strategy, size_t m) {
+    switch (strategy) {
+        case MLS_STRATEGY_TABLE:      return order_table_memory(int(m), ORDER_TABLE_NONE);
+        case MLS_STRATEGY_DENSE:      return order_table_memory(int(m), ORDER_TABLE_DENSE);
+        case MLS_STRATEGY_TILED:      return order_table_memory(int(m), ORDER_TABLE_TILED);
+        case MLS_STRATEGY_PACKED:     return mls_workspace_size(m) * sizeof(double);
+        case MLS_STRATEGY_STRUCTURED: return order_structured_memory(m);
+    }
+    return 0;
+}
+
+const char* mls_strategy_name(MlsStrategy strategy) {
+    switch (strategy) {
+        case MLS_STRATEGY_TABLE:      return "table";
+        case MLS_STRATEGY_DENSE:      return "dense";
+        case MLS_STRATEGY_TILED:      return "tiled";
+        case MLS_STRATEGY_PACKED:     return "packed";
+        case MLS_STRATEGY_STRUCTURED: return "structured";
+    }
+    return "unknown";
+}
+
+static bool mls_fits(MlsStrategy strategy, size_t m) {
+    size_t budget = mls_memory_budget();
+    return budget == 0 || mls_strategy_memory(strategy, m) <= budget;
+}
+
+// Замер пика резидентной памяти процесса: сброс VmHWM (запись "5" в clear_refs)
+// и разность VmHWM после оценки с VmRSS до нее. Пик общий для процесса,
+// поэтому параллельные вычисления в других потоках входят в замер.
+static size_t mls_status_kb(const char* key) {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t len = std::strlen(key);
+    while (std::getline(status, line)) {
+        if (line.compare(0, len, key) == 0 && line.size() > len && line[len] == ':') {
+            return std::strtoul(line.c_str() + len + 1, nullptr, 10);
         }
-        double er, vrs;
-        ordern(n, fcum[i], fcum[i], er, vrs);
-        x(i, 0) = 1.0;      // столбец для μ
-        x(i, 1) = er;       // столбец для σ (математическое ожидание порядковой статистики)
-        y(i, 0) = ycum[i];  // наблюдаемые значения
     }
+#else
+    (void)key;
+#endif
+    return 0;
+}
 
-    // Взвешенный МНК через Boost
-    MleastSquare_weight(x, y, v, db, b, yr);
+static bool mls_peak_reset() {
+#ifdef __linux__
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.close();
+    return !clear_refs.fail();
+#else
+    return false;
+#endif
+}
 
-    // Результаты: b(0,0) = μ, b(1,0) = σ
-    result.parameters.push_back(b(0, 0));  // μ
-    result.parameters.push_back(b(1, 0));  // σ
+// ============ Взвешенный МНК по порядковым статистикам ============
+// Регрессия ycum = b0 + b1 * E, где E и V - моменты порядковых статистик
+// семейства family с вероятностями fcum (m); b = (b0, b1), db = (X^T V^{-1} X)^{-1}.
+// Способ решения выбирается по размеру и бюджету памяти (mls_set_memory_budget):
+// готовые веса из кеша (полная выборка), структурированная ковариация
+// для больших выборок или плотная упакованная матрица в рабочей области ws.
+// memory (может быть nullptr) - выбранный способ, оценка и замер пика памяти.
+static void mls_order_gls(OrderFamily family, int n, const double* fcum, const double* ycum, int m,
+                          bool complete, GlsWorkspace& ws, double* b, Mat2& db,
+                          MlsMemoryReport* memory = nullptr) {
+    size_t rss_before = 0;
+    bool measured = false;
+    if (memory != nullptr) {
+        rss_before = mls_status_kb("VmRSS");
+        measured = rss_before > 0 && mls_peak_reset();
+    }
 
-    // Вычисление логарифма функции правдоподобия
-    result.log_likelihood = 0.0;
-    for (double x_val : data) {
-        double z = (x_val - b(0, 0)) / b(1, 0);
-        result.log_likelihood += -0.5 * log(2 * M_PI) - log(b(1, 0)) - 0.5 * z * z;
+    const OrderTable* table = nullptr;
+    MlsStrategy strategy = MLS_STRATEGY_TABLE;
+    if (complete && order_cache_enabled()) {
+        table = order_table(family, n, ORDER_TABLE_NONE);
+        if (table == nullptr && mls_fits(MLS_STRATEGY_DENSE, n)) {
+            strategy = MLS_STRATEGY_DENSE;
+            table = order_table(family, n, ORDER_TABLE_DENSE);
+        } else if (table == nullptr && mls_fits(MLS_STRATEGY_TILED, n)) {
+            strategy = MLS_STRATEGY_TILED;
+            table = order_table(family, n, ORDER_TABLE_TILED);
+        }
+    }
+    if (table == nullptr) {
+        strategy = (m < MLS_STRUCTURED_MIN_N && mls_fits(MLS_STRATEGY_PACKED, m)) ? MLS_STRATEGY_PACKED
+                                                                                  : MLS_STRATEGY_STRUCTURED;
+        if (!mls_fits(strategy, m)) {
+            throw std::runtime_error("MLS: оценка памяти " + std::to_string(mls_strategy_memory(strategy, m)) +
+                                     " байт превышает бюджет " + std::to_string(mls_memory_budget()) +
+                                     " (mls_set_memory_budget)");
+        }
     }
 
-    // Ковариационная матрица параметров (из взвешенного МНК)
-    // Теперь используем обычный массив для совместимости с MLEResult
-    result.cov_size = 2;
-    result.covariance = new double*[2];
-    for (int i = 0; i < 2; i++) {
-        result.covariance[i] = new double[2];
-        for (int j = 0; j < 2; j++) {
-            result.covariance[i][j] = db(i, j);
+    if (table != nullptr) {
+        // Таблица для данного n уже построена: b = W * ycum за O(n)
+        for (int k = 0; k < 2; k++) {
+            b[k] = 0.0;
+            for (int i = 0; i < n; i++) {
+                b[k] += table->w[k * n + i] * ycum[i];
+            }
+            for (int j = 0; j < 2; j++) {
+                db(k, j) = table->db[k * 2 + j];
+            }
+        }
+    } else if (strategy == MLS_STRATEGY_STRUCTURED) {
+        // Большая выборка: полуразделимая ковариация без матрицы m x m
+        Matrix x = createMatrix(m, 2);
+        Matrix y = createMatrix(m, 1);
+        Vector er;
+        Vector yr(m);
+        OrderCovariance cov;
+        order_covariance_structured(family, n, std::vector<double>(fcum, fcum + m), er, cov);
+
+        for (int i = 0; i < m; i++) {
+            x(i, 0) = 1.0;
+            x(i, 1) = er(i);
+            y(i, 0) = ycum[i];
         }
+
+        Matrix bm(2, 1), dbm(2, 2);
+        MleastSquare_structured(x, y, cov, dbm, bm, yr);
+        for (int k = 0; k < 2; k++) {
+            b[k] = bm(k, 0);
+            for (int j = 0; j < 2; j++) {
+                db(k, j) = dbm(k, j);
+            }
+        }
+    } else {
+        // Упакованная ковариация, разложение Холецкого и отбеленные X, y - в рабочей области
+        MleastSquare_order(family, n, fcum, ycum, m, ws, b, db.data());
     }
 
-    // Стандартные ошибки
-    result.std_errors.push_back(std::sqrt(std::abs(db(0, 0))));
-    result.std_errors.push_back(std::sqrt(std::abs(db(1, 1))));
+    if (memory != nullptr) {
+        memory->strategy = strategy;
+        memory->budget = mls_memory_budget();
+        memory->estimated_peak = mls_strategy_memory(strategy, table != nullptr ? n : m);
+        size_t hwm = measured ? mls_status_kb("VmHWM") : 0;
+        memory->measured_peak = hwm > rss_before ? (hwm - rss_before) * 1024 : 0;
+    }
+}
+
+// ============ MLS для нормального распределения (ТОЛЬКО полные данные) ============
+// Использует взвешенный МНК через порядковые статистики Агамирова (ordern)
+MLEResult mls_normal_complete(const std::vector<double>& data) {
+    GlsWorkspace ws;
+    return mls_normal_complete(data, ws);
+}
+
+MLEResult mls_normal_complete(const std::vector<double>& data, GlsWorkspace& ws, MlsMemoryReport* memory) {
+    MLEResult result;
+    int n = data.size();
+
+    // Начальная оценка - MLE (выборочные моменты)
+    double mean, variance;
+    normal_sample_moments(data, mean, variance, result.initial_log_likelihood);
+    result.initial_parameters = {mean, std::sqrt(variance)};
+
+    // Вычисление эмпирической функции распределения (все данные полные)
+    GlsWorkspace::Scope scope(ws);
+    double* fcum = ws.take(n);
+    double* ycum = ws.take(n);
+    cum(n, data.data(), nullptr, n, fcum, ycum, ws);
+
+    // Взвешенный МНК: ycum = μ + σ * E(порядковых статистик)
+    double b[2];
+    Mat2 db;
+    mls_order_gls(ORDER_NORMAL, n, fcum, ycum, n, true, ws, b, db, memory);
+
+    // Результаты: b[0] = μ, b[1] = σ
+    result.parameters.push_back(b[0]);  // μ
+    result.parameters.push_back(b[1]);  // σ
+
+    // Вычисление логарифма функции правдоподобия
+    result.log_likelihood = 0.0;
+    for (double x_val : data) {
+        double z = (x_val - b[0]) / b[1];
+        result.log_likelihood += -0.5 * log(2 * M_PI) - log(b[1]) - 0.5 * z * z;
+    }
+
+    // Ковариация ошибок порядковых статистик равна σ² V, поэтому cov(b) = σ² db
+    // (как в mls_normal_progressive) и стандартные ошибки
+    store_covariance(result, (b[1] * b[1]) * db);
 
     result.iterations = 0;  // Прямое вычисление
     result.converged = true;
@@ -249,6 +637,67 @@ MLEResult mls_normal_complete(const std::vector<double>& data) {
     return result;
 }
 
+// ============ MLS для нормального распределения (цензура II типа и прогрессивная) ============
+// Система строится только для km отказов: вероятности порядковых статистик
+// берутся по скорректированным рангам (cum), моменты - для выборки объема n.
+// Стоимость - O(km²) для плотной матрицы или O(km) для структурированной.
+MLEResult mls_normal_progressive(const std::vector<double>& data, const std::vector<int>& censored) {
+    GlsWorkspace ws;
+    return mls_normal_progressive(data, censored, ws);
+}
+
+MLEResult mls_normal_progressive(const std::vector<double>& data, const std::vector<int>& censored,
+                                 GlsWorkspace& ws) {
+    MLEResult result;
+    int n = data.size();
+    int km = std::count(censored.begin(), censored.end(), 0);
+    if (km < 2) {
+        throw std::runtime_error("Для MLS необходимо не менее двух полных наблюдений");
+    }
+
+    GlsWorkspace::Scope scope(ws);
+    double* fcum = ws.take(km);
+    double* ycum = ws.take(km);
+    cum(n, data.data(), censored.data(), km, fcum, ycum, ws);
+
+    // Начальная оценка - выборочные моменты полных наблюдений
+    double cp, cko;
+    standart(km, ycum, cp, cko);
+    result.initial_parameters = {cp, cko};
+
+    // Взвешенный МНК по km отказам: ycum = μ + σ * E
+    double b[2];
+    Mat2 db;
+    mls_order_gls(ORDER_NORMAL, n, fcum, ycum, km, km == n, ws, b, db);
+
+    double a = b[0];
+    double s = b[1];
+    result.parameters = {a, s};
+
+    // Ковариация ошибок порядковых статистик равна σ² V, поэтому cov(b) = σ² db
+    store_covariance(result, (s * s) * db);
+
+    // Логарифм функции правдоподобия с учетом цензуры
+    result.log_likelihood = 0.0;
+    result.initial_log_likelihood = 0.0;
+    for (int i = 0; i < n; i++) {
+        double z = (data[i] - a) / s;
+        double z0 = (data[i] - cp) / cko;
+        if (censored[i] == 0) {
+            result.log_likelihood += std::log(norm_pdf(z) / s);
+            result.initial_log_likelihood += std::log(norm_pdf(z0) / cko);
+        } else {
+            result.log_likelihood += std::log(1.0 - norm_cdf(z));
+            result.initial_log_likelihood += std::log(1.0 - norm_cdf(z0));
+        }
+    }
+
+    result.iterations = 0;  // Прямое вычисление
+    result.converged = true;
+
+    return result;
+}
+
 // (продолжение в следующей части)
 // (продолжение src/mle_methods.cpp)
 
@@ -256,13 +705,11 @@ MLEResult mls_normal_complete(const std::vector<double>& data) {
 MLEResult mle_weibull_complete(const std::vector<double>& data) {
     MLEResult result;
 
-    // Сохранение данных в глобальную структуру
-    nesm.n = data.size();
-    nesm.x = data;
-    nesm.r = std::vector<int>(data.size(), 0);
+    // Данные целевой функции (полная выборка)
+    FitContext ctx(data, std::vector<int>());
 
     // Начальная оценка параметра формы
-    std::vector<double> x0 = {1.5};
+    std::array<double, 1> x0 = {1.5};
     result.initial_parameters.push_back(x0[0]); // начальное k
 
     // Вычисление начального λ для k=1.5
@@ -281,10 +728,9 @@ MLEResult mle_weibull_complete(const std::vector<double>& data) {
                   pow(x / scale_initial, x0[0]);
     }
 
-    // Оптимизация
-    double eps = 1e-8;
-    NelderMeadResult nm_result = neldermead_detailed(x0, eps, WeibullMinFunction);
-    double shape = nm_result.parameters[0];
+    // Параметр формы - корень профильного уравнения правдоподобия
+    RootResult shape_root = weibull_shape_mle(ctx, x0[0]);
+    double shape = shape_root.root;
 
     // Вычисление параметра масштаба λ
     // λ = (1/n * Σ x_i^k)^(1/k)
@@ -295,24 +741,14 @@ MLEResult mle_weibull_complete(const std::vector<double>& data) {
     double scale = pow(sum / n, 1.0 / shape);
 
     result.parameters = {scale, shape};
-    result.iterations = nm_result.iterations;
-    result.converged = nm_result.converged;
-    result.cov_size = 2;
+    result.iterations = shape_root.evaluations;
+    result.converged = shape_root.converged;
 
-    // Вычисление ковариационной матрицы (приближенная формула)
-    result.covariance = new double*[2];
-    for (int i = 0; i < 2; i++) {
-        result.covariance[i] = new double[2]();
-    }
-    double var_lambda = (scale * scale) / (n * shape * shape);
-    double var_k = 1.644 * (shape * shape) / n;
-    result.covariance[0][0] = var_lambda;
-    result.covariance[0][1] = 0.0;
-    result.covariance[1][0] = 0.0;
-    result.covariance[1][1] = var_k;
-
-    // Стандартные ошибки
-    result.std_errors = {std::sqrt(var_lambda), std::sqrt(var_k)};
+    // Ковариационная матрица (приближенная формула) и стандартные ошибки
+    Mat2 cov;
+    cov(0, 0) = (scale * scale) / (n * shape * shape);
+    cov(1, 1) = 1.644 * (shape * shape) / n;
+    store_covariance(result, cov);
 
     // Логарифм функции правдоподобия
     // log L = n*log(k/λ) + (k-1)*Σlog(x_i) - Σ(x_i/λ)^k
@@ -325,7 +761,319 @@ MLEResult mle_weibull_complete(const std::vector<double>& data) {
     return result;
 }
 
-// MLS для Вейбулла не реализован - используется только MLE
+// ============ MLS для распределения Вейбулла (полные данные) ============
+// Логарифмы данных Вейбулла - распределение экстремальных значений со сдвигом
+// ln(λ) и масштабом 1/k, поэтому ln x_(i) = ln(λ) + (1/k) * E_i, где E_i - ожидания
+// порядковых статистик orderw. Оценки получаются одним решением взвешенного МНК.
+MLEResult mls_weibull_complete(const std::vector<double>& data) {
+    GlsWorkspace ws;
+    return mls_weibull_complete(data, ws);
+}
+
+MLEResult mls_weibull_complete(const std::vector<double>& data, GlsWorkspace& ws) {
+    MLEResult result;
+    int n = data.size();
+
+    // Подготовка данных: логарифмическая шкала, все наблюдения полные
+    GlsWorkspace::Scope scope(ws);
+    double* log_data = ws.take(n);
+    for (int i = 0; i < n; i++) {
+        if (data[i] <= 0) {
+            throw std::runtime_error("Данные для распределения Вейбулла должны быть положительными");
+        }
+        log_data[i] = std::log(data[i]);
+    }
+    double* fcum = ws.take(n);
+    double* ycum = ws.take(n);
+    cum(n, log_data, nullptr, n, fcum, ycum, ws);
+
+    double b[2];
+    Mat2 db;
+    mls_order_gls(ORDER_WEIBULL, n, fcum, ycum, n, true, ws, b, db);
+
+    // b[0] = ln(λ), b[1] = 1/k
+    double cpw = b[0];
+    double ckow = b[1];
+    double scale = std::exp(cpw);
+    double shape = 1.0 / ckow;
+
+    result.parameters = {scale, shape};
+    result.initial_parameters = result.parameters;  // прямое решение, без итераций
+
+    // Ковариация (ln λ, 1/k) = ckow² * db (ковариация лог-данных пропорциональна квадрату масштаба),
+    // затем переход к (λ, k) по дельта-методу: dλ/d(ln λ) = λ, dk/d(1/k) = -k²
+    double g[2] = {scale, -shape * shape};
+    store_covariance(result, scale_symmetric((ckow * ckow) * db, g));
+
+    // log L = n*log(k/λ) + (k-1)*Σlog(x_i/λ) - Σ(x_i/λ)^k
+    result.log_likelihood = 0.0;
+    for (double x : data) {
+        result.log_likelihood += log(shape / scale) + (shape - 1) * log(x / scale) -
+                  pow(x / scale, shape);
+    }
+    result.initial_log_likelihood = result.log_likelihood;
+
+    result.iterations = 0;  // Прямое вычисление
+    result.converged = true;
+
+    return result;
+}
+
+// ============ MLS для распределения Вейбулла (цензура II типа и прогрессивная) ============
+MLEResult mls_weibull_progressive(const std::vector<double>& data, const std::vector<int>& censored) {
+    GlsWorkspace ws;
+    return mls_weibull_progressive(data, censored, ws);
+}
+
+MLEResult mls_weibull_progressive(const std::vector<double>& data, const std::vector<int>& censored,
+                                  GlsWorkspace& ws) {
+    MLEResult result;
+    int n = data.size();
+    int km = std::count(censored.begin(), censored.end(), 0);
+    if (km < 2) {
+        throw std::runtime_error("Для MLS необходимо не менее двух полных наблюдений");
+    }
+
+    GlsWorkspace::Scope scope(ws);
+    double* log_data = ws.take(n);
+    for (int i = 0; i < n; i++) {
+        if (data[i] <= 0) {
+            throw std::runtime_error("Данные для распределения Вейбулла должны быть положительными");
+        }
+        log_data[i] = std::log(data[i]);
+    }
+    double* fcum = ws.take(km);
+    double* ycum = ws.take(km);
+    cum(n, log_data, censored.data(), km, fcum, ycum, ws);
+
+    double b[2];
+    Mat2 db;
+    mls_order_gls(ORDER_WEIBULL, n, fcum, ycum, km, km == n, ws, b, db);
+
+    double cpw = b[0];
+    double ckow = b[1];
+    double scale = std::exp(cpw);
+    double shape = 1.0 / ckow;
+
+    result.parameters = {scale, shape};
+    result.initial_parameters = result.parameters;
+
+    // Как в mls_weibull_complete: ckow² * db и дельта-метод
+    double g[2] = {scale, -shape * shape};
+    store_covariance(result, scale_symmetric((ckow * ckow) * db, g));
+
+    // log L = Σ[r_i=0: log(k/λ) + (k-1)*log(x_i/λ) - (x_i/λ)^k] + Σ[r_i=1: -(x_i/λ)^k]
+    result.log_likelihood = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (censored[i] == 0) {
+            result.log_likelihood += log(shape / scale) + (shape - 1) * log(data[i] / scale);
+        }
+        result.log_likelihood -= pow(data[i] / scale, shape);
+    }
+    result.initial_log_likelihood = result.log_likelihood;
+
+    result.iterations = 0;  // Прямое вычисление
+    result.converged = true;
+
+    return result;
+}
+
+// ============ Совместный MLS по нескольким подвыборкам ============
+// Подвыборка j: y_ji = a_j + s * E_ji, ковариация ошибок s² V_j. Матрица плана
+// блочная: свой столбец сдвига у каждой подвыборки и общий столбец масштаба,
+// V = diag(V_1..V_k). Поэтому X^T V^{-1} X - "стрелка": диагональ из d_j,
+// последняя строка u_j и угол w = sum_j w_j, где (d_j, u_j, w_j) - нормальные
+// уравнения регрессии [1, E_j] на своей подвыборке. Блоки решаются независимо
+// (параллельно), затем малая система (k+1) x (k+1) решается через дополнение Шура.
+static void mls_multisample_gls(OrderFamily family, const std::vector<double>& y,
+                                const std::vector<int>& censored, const std::vector<int>& nsample,
+                                std::vector<double>& theta, Matrix& dtheta) {
+    size_t k = nsample.size();
+    if (k == 0) {
+        throw std::runtime_error("Не заданы размеры подвыборок");
+    }
+
+    std::vector<size_t> offset(k + 1, 0);
+    for (size_t j = 0; j < k; j++) {
+        if (nsample[j] < 2) {
+            throw std::runtime_error("Размер подвыборки должен быть не менее 2");
+        }
+        offset[j + 1] = offset[j] + nsample[j];
+    }
+    if (offset[k] != y.size() || censored.size() != y.size()) {
+        throw std::runtime_error("Сумма размеров подвыборок не совпадает с объемом данных");
+    }
+
+    // Нормальные уравнения блока: [d u; u w] и правая часть (c0, c1)
+    std::vector<double> d(k), u(k), w(k), c0(k), c1(k);
+    std::vector<std::exception_ptr> errors(k);
+
+    global_thread_pool().parallel_for(k, [&](size_t j) {
+        try {
+            int n = nsample[j];
+            std::vector<double> data(y.begin() + offset[j], y.begin() + offset[j + 1]);
+            std::vector<int> r(censored.begin() + offset[j], censored.begin() + offset[j + 1]);
+            int km = std::count(r.begin(), r.end(), 0);
+            if (km < 2) {
+                throw std::runtime_error("Для MLS необходимо не менее двух полных наблюдений");
+            }
+
+            std::vector<double> fcum(km);
+            std::vector<double> ycum(km);
+            cum(n, data, r, km, fcum, ycum);
+
+            GlsWorkspace ws;
+            double b[2];
+            Mat2 db;
+            mls_order_gls(family, n, fcum.data(), ycum.data(), km, km == n, ws, b, db);
+
+            // db = (X^T V^{-1} X)^{-1}, b = db * X^T V^{-1} y
+            Mat2 a = inverse(db);
+            d[j] = a(0, 0);
+            u[j] = a(0, 1);
+            w[j] = a(1, 1);
+            c0[j] = d[j] * b[0] + u[j] * b[1];
+            c1[j] = u[j] * b[0] + w[j] * b[1];
+        } catch (...) {
+            errors[j] = std::current_exception();
+        }
+    });
+    for (size_t j = 0; j < k; j++) {
+        if (errors[j]) std::rethrow_exception(errors[j]);
+    }
+
+    // Дополнение Шура для общего столбца: s = w - sum u_j² / d_j
+    double schur = 0.0;
+    double rhs = 0.0;
+    for (size_t j = 0; j < k; j++) {
+        schur += w[j] - u[j] * u[j] / d[j];
+        rhs += c1[j] - u[j] * c0[j] / d[j];
+    }
+    if (!(schur > 0.0)) {
+        throw std::runtime_error("Матрица нормальных уравнений вырожденная");
+    }
+
+    theta.assign(k + 1, 0.0);
+    theta[k] = rhs / schur;
+    for (size_t j = 0; j < k; j++) {
+        theta[j] = (c0[j] - u[j] * theta[k]) / d[j];
+    }
+
+    // Обратная матрица "стрелки" в явном виде
+    dtheta = createMatrix(k + 1, k + 1);
+    dtheta(k, k) = 1.0 / schur;
+    for (size_t i = 0; i < k; i++) {
+        double gi = u[i] / d[i];
+        dtheta(i, k) = dtheta(k, i) = -gi / schur;
+        for (size_t j = 0; j < k; j++) {
+            dtheta(i, j) = gi * (u[j] / d[j]) / schur + (i == j ? 1.0 / d[i] : 0.0);
+        }
+    }
+}
+
+// ============ Совместный MLS для нормального распределения ============
+MLEResult mls_normal_multisample(const std::vector<double>& data, const std::vector<int>& censored,
+                                 const std::vector<int>& nsample) {
+    MLEResult result;
+    size_t k = nsample.size();
+
+    std::vector<double> theta;
+    Matrix dtheta;
+    mls_multisample_gls(ORDER_NORMAL, data, censored, nsample, theta, dtheta);
+    double s = theta[k];
+
+    result.parameters = theta;
+    result.initial_parameters = theta;  // прямое решение, без итераций
+
+    // cov(theta) = s² (X^T V^{-1} X)^{-1}
+    CovarianceMatrix cov(k + 1);
+    for (size_t i = 0; i <= k; i++) {
+        for (size_t j = 0; j <= k; j++) {
+            cov(i, j) = s * s * dtheta(i, j);
+        }
+    }
+    store_covariance(result, std::move(cov));
+
+    // Сумма логарифмов правдоподобия подвыборок с учетом цензуры
+    result.log_likelihood = 0.0;
+    size_t pos = 0;
+    for (size_t j = 0; j < k; j++) {
+        for (int i = 0; i < nsample[j]; i++, pos++) {
+            double z = (data[pos] - theta[j]) / s;
+            if (censored[pos] == 0) {
+                result.log_likelihood += std::log(norm_pdf(z) / s);
+            } else {
+                result.log_likelihood += std::log(1.0 - norm_cdf(z));
+            }
+        }
+    }
+    result.initial_log_likelihood = result.log_likelihood;
+
+    result.iterations = 0;  // Прямое вычисление
+    result.converged = true;
+
+    return result;
+}
+
+// ============ Совместный MLS для распределения Вейбулла ============
+// В логарифмической шкале общий параметр формы дает общий масштаб 1/k,
+// а параметры масштаба подвыборок - сдвиги ln(λ_j)
+MLEResult mls_weibull_multisample(const std::vector<double>& data, const std::vector<int>& censored,
+                                  const std::vector<int>& nsample) {
+    MLEResult result;
+    size_t k = nsample.size();
+
+    std::vector<double> log_data(data.size());
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] <= 0) {
+            throw std::runtime_error("Данные для распределения Вейбулла должны быть положительными");
+        }
+        log_data[i] = std::log(data[i]);
+    }
+
+    std::vector<double> theta;
+    Matrix dtheta;
+    mls_multisample_gls(ORDER_WEIBULL, log_data, censored, nsample, theta, dtheta);
+    double ckow = theta[k];
+    double shape = 1.0 / ckow;
+
+    // Параметры: λ_1..λ_k, k
+    std::vector<double> g(k + 1);
+    for (size_t j = 0; j < k; j++) {
+        result.parameters.push_back(std::exp(theta[j]));
+        g[j] = result.parameters[j];
+    }
+    result.parameters.push_back(shape);
+    g[k] = -shape * shape;
+    result.initial_parameters = result.parameters;
+
+    // Как в mls_weibull_complete: ckow² * dtheta и дельта-метод
+    CovarianceMatrix cov(k + 1);
+    for (size_t i = 0; i <= k; i++) {
+        for (size_t j = 0; j <= k; j++) {
+            cov(i, j) = g[i] * g[j] * ckow * ckow * dtheta(i, j);
+        }
+    }
+    store_covariance(result, std::move(cov));
+
+    result.log_likelihood = 0.0;
+    size_t pos = 0;
+    for (size_t j = 0; j < k; j++) {
+        double scale = result.parameters[j];
+        for (int i = 0; i < nsample[j]; i++, pos++) {
+            if (censored[pos] == 0) {
+                result.log_likelihood += log(shape / scale) + (shape - 1) * log(data[pos] / scale);
+            }
+            result.log_likelihood -= pow(data[pos] / scale, shape);
+        }
+    }
+    result.initial_log_likelihood = result.log_likelihood;
+
+    result.iterations = 0;  // Прямое вычисление
+    result.converged = true;
+
+    return result;
+}
 
 // ============ Вывод результатов MLE ============
 void print_mle_result(const MLEResult& result, const char* method_name) {
@@ -343,10 +1091,11 @@ void print_mle_result(const MLEResult& result, const char* method_name) {
     std::cout << "Сходимость: " << (result.converged ? "Да" : "Нет") << "\n";
 
     // Вывод ковариационной матрицы (конвертируем в Boost.uBLAS для вывода)
-    Matrix cov_matrix(result.cov_size, result.cov_size);
-    for (int i = 0; i < result.cov_size; i++) {
-        for (int j = 0; j < result.cov_size; j++) {
-            cov_matrix(i, j) = result.covariance[i][j];
+    size_t m = result.covariance.size();
+    Matrix cov_matrix(m, m);
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < m; j++) {
+            cov_matrix(i, j) = result.covariance(i, j);
         }
     }
     printMatrix(cov_matrix, "Ковариационная матрица");
@@ -386,9 +1135,9 @@ void save_mle_result(const MLEResult& result, const char* filename,
     file << "converged " << (result.converged ? 1 : 0) << "\n";
 
     file << "\n# Ковариационная матрица\n";
-    for (int i = 0; i < result.cov_size; ++i) {
-        for (int j = 0; j < result.cov_size; ++j) {
-            file << result.covariance[i][j] << " ";
+    for (size_t i = 0; i < result.covariance.size(); ++i) {
+        for (size_t j = 0; j < result.covariance.size(); ++j) {
+            file << result.covariance(i, j) << " ";
         }
         file << "\n";
     }
@@ -404,10 +1153,8 @@ void save_mle_result(const MLEResult& result, const char* filename,
     std::cout << "Результаты сохранены в файл: " << filename << "\n";
 }
 
-// ============ Освобождение памяти результата ============
+// ============ Сброс результата ============
+// Память ковариации освобождается деструктором MLEResult
 void free_mle_result(MLEResult& result) {
-    if (result.covariance != nullptr) {
-        clearMemory(result.covariance, result.cov_size);
-        result.covariance = nullptr;
-    }
+    result.covariance = CovarianceMatrix();
 }
\ No newline at end of file
@@ -40,21 +40,20 @@ MLEResult mle_normal_complete(const std::vector<double>& data) {
     result.log_likelihood = log_likelihood;
 
     // Вычисление ковариационной матрицы
-    result.cov_size = 2;
-    result.covariance = createMatrix(2, 2);
-
     // Для нормального распределения:
     // Var(μ) = σ²/n
     // Var(σ) = σ²/(2n)
     // Cov(μ, σ) = 0
-    result.covariance[0][0] = variance / n;
-    result.covariance[0][1] = 0.0;
-    result.covariance[1][0] = 0.0;
-    result.covariance[1][1] = variance / (2.0 * n);
+    Mat2 cov;
+    cov(0, 0) = variance / n;
+    cov(0, 1) = 0.0;
+    cov(1, 0) = 0.0;
+    cov(1, 1) = variance / (2.0 * n);
+    result.covariance = cov;
 
     // Стандартные ошибки
-    result.std_errors.push_back(std::sqrt(result.covariance[0][0]));
-    result.std_errors.push_back(std::sqrt(result.covariance[1][1]));
+    result.std_errors.push_back(std::sqrt(cov(0, 0)));
+    result.std_errors.push_back(std::sqrt(cov(1, 1)));
 
     result.iterations = 0;  // Аналитическое решение
     result.converged = true;
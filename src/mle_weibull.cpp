@@ -9,21 +9,18 @@
 #include "boost_distributions.h"
 #include "matrix_operations.h"
 
-// Глобальная структура для хранения данных
-ne_simp global_data_weibull;
-
-// Целевая функция для оптимизации Вейбулла (полные данные)
+// Целевая функция для оптимизации Вейбулла (полные данные ctx)
 // Минимизируем отрицательный log-likelihood
-double WeibullObjective(std::vector<double> params) {
+double WeibullObjective(const FitContext& ctx, const std::vector<double>& params) {
     double k = params[0];  // параметр формы
     if (k <= 0 || k > 100) return 1e10;  // Ограничения
 
-    int n = global_data_weibull.n;
+    int n = ctx.n;
 
     // Вычисляем λ для данного k
     double sum_xk = 0.0;
     for (int i = 0; i < n; i++) {
-        sum_xk += std::pow(global_data_weibull.x[i], k);
+        sum_xk += std::pow(ctx.x[i], k);
     }
     double lambda = std::pow(sum_xk / n, 1.0 / k);
 
@@ -32,7 +29,7 @@ double WeibullObjective(std::vector<double> params) {
     // Вычисляем отрицательный log-likelihood
     double neg_log_likelihood = 0.0;
     for (int i = 0; i < n; i++) {
-        double x = global_data_weibull.x[i];
+        double x = ctx.x[i];
         if (x <= 0) continue;
 
         // -log L = -log(k/λ) - (k-1)*log(x) + (x/λ)^k
@@ -47,11 +44,8 @@ MLEResult mle_weibull_complete(const std::vector<double>& data) {
     MLEResult result;
     int n = data.size();
 
-    // Настройка глобальных данных
-    global_data_weibull.n = n;
-    global_data_weibull.x = data;
-    global_data_weibull.r = std::vector<int>(n, 0);  // Все наблюдения полные
-    global_data_weibull.nsample.clear();
+    // Данные целевой функции: все наблюдения полные
+    FitContext ctx(data, std::vector<int>());
 
     // Начальная оценка параметра формы (метод моментов)
     double mean = std::accumulate(data.begin(), data.end(), 0.0) / n;
@@ -66,12 +60,9 @@ MLEResult mle_weibull_complete(const std::vector<double>& data) {
     double c_init = 1.0 / cv;  // Грубая начальная оценка
     if (c_init <= 0) c_init = 1.0;
 
-    // Оптимизация методом Nelder-Mead
-    std::vector<double> x0 = {c_init};
-    double eps = 1e-6;
-    std::vector<double> optimal = neldermead(x0, eps, WeibullObjective);
-
-    double k = optimal[0];  // параметр формы
+    // Параметр формы - корень профильного уравнения правдоподобия
+    // (минимум WeibullObjective по k, без перебора симплексом)
+    double k = weibull_shape_mle(ctx, c_init).root;  // параметр формы
 
     // Правильная формула для параметра масштаба λ
     // λ = (1/n * Σ x_i^k)^(1/k)
@@ -94,19 +85,18 @@ MLEResult mle_weibull_complete(const std::vector<double>& data) {
     result.log_likelihood = log_likelihood;
 
     // Вычисление ковариационной матрицы через информационную матрицу Фишера
-    result.cov_size = 2;
-    result.covariance = createMatrix(2, 2);
-
     // Приближенная ковариационная матрица для Вейбулла
     // Используем формулы из теории (упрощенные)
     double var_lambda = (lambda * lambda) / (n * k * k);  // Var(λ̂)
     double var_k = 1.644 * (k * k) / n;                    // Var(k̂) (приближенно)
     double cov_lambda_k = 0.0;                             // Cov(λ̂, k̂) ≈ 0 для больших n
 
-    result.covariance[0][0] = var_lambda;
-    result.covariance[0][1] = cov_lambda_k;
-    result.covariance[1][0] = cov_lambda_k;
-    result.covariance[1][1] = var_k;
+    Mat2 cov;
+    cov(0, 0) = var_lambda;
+    cov(0, 1) = cov_lambda_k;
+    cov(1, 0) = cov_lambda_k;
+    cov(1, 1) = var_k;
+    result.covariance = cov;
 
     // Стандартные ошибки
     result.std_errors.push_back(std::sqrt(var_lambda));
@@ -13,11 +13,8 @@ MLEResult mls_weibull_censored(const std::vector<double>& data, const std::vecto
     MLEResult result;
     int n = data.size();
 
-    // Установка глобальных данных для оптимизации
-    nesm.n = n;
-    nesm.x = data;
-    nesm.r = censored;
-    nesm.nsample.clear();
+    // Данные целевой функции
+    FitContext ctx(data, censored);
 
     // Начальные оценки (используем только полные наблюдения)
     double sum = 0.0;
@@ -42,12 +39,8 @@ MLEResult mls_weibull_censored(const std::vector<double>& data, const std::vecto
     double cv = std::sqrt(variance_init) / mean_init;
     double c_init = std::max(1.0, 1.0 / cv);
 
-    // Оптимизация методом Nelder-Mead
-    std::vector<double> x0 = {c_init};
-    double eps = 1e-6;
-    std::vector<double> optimal = neldermead(x0, eps, WeibullMinFunction);
-
-    double k = optimal[0];  // параметр формы
+    // Параметр формы - корень профильного уравнения правдоподобия
+    double k = weibull_shape_mle(ctx, c_init).root;  // параметр формы
 
     // Вычисление параметра масштаба λ
     // λ = (1/n * Σ x_i^k)^(1/k) для всех данных (включая цензурированные)
@@ -76,18 +69,17 @@ MLEResult mls_weibull_censored(const std::vector<double>& data, const std::vecto
     result.log_likelihood = log_likelihood;
 
     // Вычисление ковариационной матрицы
-    result.cov_size = 2;
-    result.covariance = createMatrix(2, 2);
-
     // Приближенная ковариационная матрица для цензурированных данных
     double var_lambda = (lambda * lambda) / (n_complete * k * k);
     double var_k = 1.644 * (k * k) / n_complete;
     double cov_lambda_k = 0.0;
 
-    result.covariance[0][0] = var_lambda;
-    result.covariance[0][1] = cov_lambda_k;
-    result.covariance[1][0] = cov_lambda_k;
-    result.covariance[1][1] = var_k;
+    Mat2 cov;
+    cov(0, 0) = var_lambda;
+    cov(0, 1) = cov_lambda_k;
+    cov(1, 0) = cov_lambda_k;
+    cov(1, 1) = var_k;
+    result.covariance = cov;
 
     // Стандартные ошибки
     result.std_errors.push_back(std::sqrt(var_lambda));
@@ -1,331 +1,237 @@
 #include "nelder_mead.h"
+#include "thread_pool.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <stdexcept>
 
-// Глобальная переменная для данных оптимизации
+// Глобальная переменная для данных оптимизации (устаревшие целевые функции)
 ne_simp nesm;
 
-// Вычисление центроида симплекса (исключая наихудшую точку)
-std::vector<double> compute_centroid(const std::vector<std::vector<double>>& simplex, size_t exclude_idx) {
-    size_t n = simplex[0].size();
-    std::vector<double> centroid(n, 0.0);
-    
-    for (size_t i = 0; i < simplex.size(); ++i) {
-        if (i != exclude_idx) {
-            for (size_t j = 0; j < n; ++j) {
-                centroid[j] += simplex[i][j];
-            }
-        }
-    }
-    
-    for (size_t j = 0; j < n; ++j) {
-        centroid[j] /= (simplex.size() - 1);
-    }
-    
-    return centroid;
-}
-
-// Отражение точки относительно центроида
-std::vector<double> reflect_point(const std::vector<double>& point,
-                                  const std::vector<double>& centroid, double alpha) {
-    size_t n = point.size();
-    std::vector<double> reflected(n);
-    
-    for (size_t i = 0; i < n; ++i) {
-        reflected[i] = centroid[i] + alpha * (centroid[i] - point[i]);
-    }
-    
-    return reflected;
-}
-
-// Расширение точки
-std::vector<double> expand_point(const std::vector<double>& reflected,
-                                const std::vector<double>& centroid, double gamma) {
-    size_t n = reflected.size();
-    std::vector<double> expanded(n);
-    
-    for (size_t i = 0; i < n; ++i) {
-        expanded[i] = centroid[i] + gamma * (reflected[i] - centroid[i]);
-    }
-    
-    return expanded;
-}
-
-// Сжатие точки
-std::vector<double> contract_point(const std::vector<double>& point,
-                                  const std::vector<double>& centroid, double rho) {
-    size_t n = point.size();
-    std::vector<double> contracted(n);
-    
-    for (size_t i = 0; i < n; ++i) {
-        contracted[i] = centroid[i] + rho * (point[i] - centroid[i]);
-    }
-    
-    return contracted;
-}
+// Симплекс из векторов для neldermead и neldermead_detailed: все рабочие точки
+// выделяются один раз, итерации ядра памяти не выделяют (кроме копий
+// аргумента при вызове func по значению)
+static NelderMeadResult neldermead_vector(const std::vector<double>& x0, const NelderMeadOptions& options,
+                                          const std::function<double(std::vector<double>)>& func) {
+    size_t n = x0.size();
+    std::vector<std::vector<double>> simplex(n + 1, x0);
+    std::vector<double> f_values(n + 1);
+    std::vector<double> centroid(n), reflected(n), trial(n);
 
-// Размер симплекса (для проверки сходимости)
-double simplex_size(const std::vector<std::vector<double>>& simplex) {
-    size_t n = simplex[0].size();
-    double max_diff = 0.0;
-    
-    for (size_t i = 0; i < n; ++i) {
-        double min_val = simplex[0][i];
-        double max_val = simplex[0][i];
-        
-        for (size_t j = 1; j < simplex.size(); ++j) {
-            min_val = std::min(min_val, simplex[j][i]);
-            max_val = std::max(max_val, simplex[j][i]);
-        }
-        
-        max_diff = std::max(max_diff, max_val - min_val);
-    }
-    
-    return max_diff;
+    NelderMeadResult result;
+    neldermead_core(simplex, f_values, centroid, reflected, trial, options, func,
+                    result.iterations, result.converged, result.counters);
+    result.parameters = simplex[0];
+    result.final_value = f_values[0];
+    return result;
 }
 
 // Основная функция оптимизации методом Nelder-Mead
 std::vector<double> neldermead(std::vector<double>& x0, double eps, 
                                std::function<double(std::vector<double>)> func) {
-    const double alpha = 1.0;    // коэффициент отражения
-    const double gamma = 2.0;    // коэффициент расширения
-    const double rho = 0.5;      // коэффициент сжатия
-    const double sigma = 0.5;    // коэффициент уменьшения
-    const int max_iter = 1000;   // максимальное число итераций
-    
-    size_t n = x0.size();
-    
-    // Инициализация симплекса
-    std::vector<std::vector<double>> simplex(n + 1);
-    simplex[0] = x0;
-    
-    for (size_t i = 1; i <= n; ++i) {
-        simplex[i] = x0;
-        simplex[i][i-1] += 0.1 * (x0[i-1] != 0.0 ? x0[i-1] : 1.0);
-    }
-    
-    // Вычисление значений функции для всех вершин симплекса
-    std::vector<double> f_values(n + 1);
-    for (size_t i = 0; i <= n; ++i) {
-        f_values[i] = func(simplex[i]);
+    NelderMeadOptions options;
+    options.eps = eps;
+    NelderMeadResult result = neldermead_vector(x0, options, func);
+
+    if (result.converged) {
+        std::cout << "Сходимость достигнута на итерации " << result.iterations - 1 << std::endl;
+    } else {
+        std::cout << "Достигнуто максимальное число итераций: " << options.max_iter << std::endl;
     }
-    
-    // Основной цикл оптимизации
-    for (int iter = 0; iter < max_iter; ++iter) {
-        // Сортировка вершин по значению функции
-        std::vector<size_t> indices(n + 1);
-        std::iota(indices.begin(), indices.end(), 0);
-        std::sort(indices.begin(), indices.end(),
-                 [&f_values](size_t i, size_t j) { return f_values[i] < f_values[j]; });
-        
-        // Переупорядочивание симплекса
-        std::vector<std::vector<double>> sorted_simplex(n + 1);
-        std::vector<double> sorted_f_values(n + 1);
-        for (size_t i = 0; i <= n; ++i) {
-            sorted_simplex[i] = simplex[indices[i]];
-            sorted_f_values[i] = f_values[indices[i]];
-        }
-        simplex = sorted_simplex;
-        f_values = sorted_f_values;
-        
-        // Проверка сходимости
-        if (simplex_size(simplex) < eps) {
-            std::cout << "Сходимость достигнута на итерации " << iter << std::endl;
-            return simplex[0];
-        }
-        
-        // Вычисление центроида (исключая наихудшую точку)
-        std::vector<double> centroid = compute_centroid(simplex, n);
-        
-        // Отражение
-        std::vector<double> reflected = reflect_point(simplex[n], centroid, alpha);
-        double f_reflected = func(reflected);
-        
-        if (f_reflected < f_values[0]) {
-            // Расширение
-            std::vector<double> expanded = expand_point(reflected, centroid, gamma);
-            double f_expanded = func(expanded);
-            
-            if (f_expanded < f_reflected) {
-                simplex[n] = expanded;
-                f_values[n] = f_expanded;
-            } else {
-                simplex[n] = reflected;
-                f_values[n] = f_reflected;
-            }
-        } else if (f_reflected < f_values[n-1]) {
-            simplex[n] = reflected;
-            f_values[n] = f_reflected;
-        } else {
-            // Сжатие
-            if (f_reflected < f_values[n]) {
-                // Внешнее сжатие
-                std::vector<double> contracted = contract_point(reflected, centroid, rho);
-                double f_contracted = func(contracted);
-                
-                if (f_contracted < f_reflected) {
-                    simplex[n] = contracted;
-                    f_values[n] = f_contracted;
-                } else {
-                    // Уменьшение
-                    for (size_t i = 1; i <= n; ++i) {
-                        for (size_t j = 0; j < n; ++j) {
-                            simplex[i][j] = simplex[0][j] + sigma * (simplex[i][j] - simplex[0][j]);
-                        }
-                        f_values[i] = func(simplex[i]);
-                    }
-                }
-            } else {
-                // Внутреннее сжатие
-                std::vector<double> contracted = contract_point(simplex[n], centroid, rho);
-                double f_contracted = func(contracted);
-                
-                if (f_contracted < f_values[n]) {
-                    simplex[n] = contracted;
-                    f_values[n] = f_contracted;
-                } else {
-                    // Уменьшение
-                    for (size_t i = 1; i <= n; ++i) {
-                        for (size_t j = 0; j < n; ++j) {
-                            simplex[i][j] = simplex[0][j] + sigma * (simplex[i][j] - simplex[0][j]);
-                        }
-                        f_values[i] = func(simplex[i]);
-                    }
-                }
-            }
-        }
-    }
-    
-    std::cout << "Достигнуто максимальное число итераций: " << max_iter << std::endl;
-    return simplex[0];
+    return result.parameters;
 }
 
 // Функция оптимизации с детальной информацией о результате
 NelderMeadResult neldermead_detailed(std::vector<double>& x0, double eps,
                                      std::function<double(std::vector<double>)> func) {
-    const double alpha = 1.0;    // коэффициент отражения
-    const double gamma = 2.0;    // коэффициент расширения
-    const double rho = 0.5;      // коэффициент сжатия
-    const double sigma = 0.5;    // коэффициент уменьшения
-    const int max_iter = 1000;   // максимальное число итераций
+    NelderMeadOptions options;
+    options.eps = eps;
+    return neldermead_vector(x0, options, func);
+}
 
-    NelderMeadResult result;
-    result.converged = false;
-    result.iterations = 0;
+NelderMeadResult neldermead_detailed(std::vector<double>& x0, const NelderMeadOptions& options,
+                                     std::function<double(std::vector<double>)> func) {
+    return neldermead_vector(x0, options, func);
+}
 
-    size_t n = x0.size();
+NelderMeadResult neldermead_detailed(std::vector<double>& x0, double eps, const FitContext& ctx,
+                                     std::function<double(const FitContext&, const std::vector<double>&)> func) {
+    return neldermead_detailed(x0, eps, [&ctx, &func](std::vector<double> x) { return func(ctx, x); });
+}
+
+NelderMeadResult neldermead_detailed(std::vector<double>& x0, const NelderMeadOptions& options, const FitContext& ctx,
+                                     std::function<double(const FitContext&, const std::vector<double>&)> func) {
+    return neldermead_detailed(x0, options, [&ctx, &func](std::vector<double> x) { return func(ctx, x); });
+}
 
-    // Инициализация симплекса
-    std::vector<std::vector<double>> simplex(n + 1);
-    simplex[0] = x0;
+// ============ NelderMeadTrace ============
 
-    for (size_t i = 1; i <= n; ++i) {
-        simplex[i] = x0;
-        simplex[i][i-1] += 0.1 * (x0[i-1] != 0.0 ? x0[i-1] : 1.0);
+NelderMeadTrace::NelderMeadTrace(size_t capacity) : ring(capacity) {
+    if (capacity == 0) {
+        throw std::runtime_error("Трасса Нелдера-Мида: нулевая емкость");
     }
+}
 
-    // Вычисление значений функции для всех вершин симплекса
-    std::vector<double> f_values(n + 1);
-    for (size_t i = 0; i <= n; ++i) {
-        f_values[i] = func(simplex[i]);
+void NelderMeadTrace::on_iteration(const NelderMeadIteration& it) {
+    ring[head] = it;
+    head = (head + 1) % ring.size();
+    if (count < ring.size()) count++;
+    total++;
+}
+
+const NelderMeadIteration& NelderMeadTrace::operator[](size_t i) const {
+    if (i >= count) {
+        throw std::runtime_error("Трасса Нелдера-Мида: индекс вне диапазона");
     }
+    return ring[(head + ring.size() - count + i) % ring.size()];
+}
 
-    // Основной цикл оптимизации
-    for (int iter = 0; iter < max_iter; ++iter) {
-        result.iterations = iter + 1;
+void NelderMeadTrace::clear() {
+    head = 0;
+    count = 0;
+    total = 0;
+}
 
-        // Сортировка вершин по значению функции
-        std::vector<size_t> indices(n + 1);
-        std::iota(indices.begin(), indices.end(), 0);
-        std::sort(indices.begin(), indices.end(),
-                 [&f_values](size_t i, size_t j) { return f_values[i] < f_values[j]; });
+// ============ Мультистарт ============
 
-        // Переупорядочивание симплекса
-        std::vector<std::vector<double>> sorted_simplex(n + 1);
-        std::vector<double> sorted_f_values(n + 1);
-        for (size_t i = 0; i <= n; ++i) {
-            sorted_simplex[i] = simplex[indices[i]];
-            sorted_f_values[i] = f_values[indices[i]];
-        }
-        simplex = sorted_simplex;
-        f_values = sorted_f_values;
+// Простые основания последовательности Холтона (по одному на координату)
+static const int HALTON_BASES[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53};
+
+// Координата точки index (с 1) последовательности Холтона по основанию base, в [0, 1)
+static double halton(size_t index, int base) {
+    double f = 1.0, r = 0.0;
+    while (index > 0) {
+        f /= base;
+        r += f * double(index % base);
+        index /= base;
+    }
+    return r;
+}
 
-        // Проверка сходимости
-        if (simplex_size(simplex) < eps) {
-            result.converged = true;
-            result.parameters = simplex[0];
-            result.final_value = f_values[0];
-            return result;
+// Лучшая точка, общая для всех запусков
+struct MultiStartShared {
+    std::mutex mutex;
+    double value;
+    std::vector<double> point;
+};
+
+// Наблюдатель одного запуска: обновляет общую лучшую точку и прерывает
+// запуск, заведомо худший нее или сходящийся к ней же
+class MultiStartObserver : public NelderMeadObserver {
+public:
+    MultiStartObserver(MultiStartShared& shared, const MultiStartOptions& options,
+                       const std::vector<double>& lower, const std::vector<double>& upper)
+        : shared(shared), options(options), lower(lower), upper(upper) {}
+
+    void on_iteration(const NelderMeadIteration& it) override {
+        size_t n = lower.size();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (it.best < shared.value) {
+            shared.value = it.best;
+            shared.point.assign(it.point, it.point + n);
+            return;
         }
+        if (it.best == shared.value) return;
 
-        // Вычисление центроида (исключая наихудшую точку)
-        std::vector<double> centroid = compute_centroid(simplex, n);
+        if (it.iteration >= options.abandon_after &&
+            it.best > shared.value + options.abandon_gap * std::max(1.0, std::abs(shared.value))) {
+            abandoned = true;
+            return;
+        }
+        bool near = true;
+        for (size_t j = 0; j < n && near; j++) {
+            near = std::abs(it.point[j] - shared.point[j]) <= options.merge_radius * (upper[j] - lower[j]);
+        }
+        if (near) abandoned = true;
+    }
 
-        // Отражение
-        std::vector<double> reflected = reflect_point(simplex[n], centroid, alpha);
-        double f_reflected = func(reflected);
+    bool stop_requested() const override { return abandoned; }
 
-        if (f_reflected < f_values[0]) {
-            // Расширение
-            std::vector<double> expanded = expand_point(reflected, centroid, gamma);
-            double f_expanded = func(expanded);
+    bool abandoned = false;
 
-            if (f_expanded < f_reflected) {
-                simplex[n] = expanded;
-                f_values[n] = f_expanded;
-            } else {
-                simplex[n] = reflected;
-                f_values[n] = f_reflected;
-            }
-        } else if (f_reflected < f_values[n-1]) {
-            simplex[n] = reflected;
-            f_values[n] = f_reflected;
-        } else {
-            // Сжатие
-            if (f_reflected < f_values[n]) {
-                // Внешнее сжатие
-                std::vector<double> contracted = contract_point(reflected, centroid, rho);
-                double f_contracted = func(contracted);
+private:
+    MultiStartShared& shared;
+    const MultiStartOptions& options;
+    const std::vector<double>& lower;
+    const std::vector<double>& upper;
+};
 
-                if (f_contracted < f_reflected) {
-                    simplex[n] = contracted;
-                    f_values[n] = f_contracted;
-                } else {
-                    // Уменьшение
-                    for (size_t i = 1; i <= n; ++i) {
-                        for (size_t j = 0; j < n; ++j) {
-                            simplex[i][j] = simplex[0][j] + sigma * (simplex[i][j] - simplex[0][j]);
-                        }
-                        f_values[i] = func(simplex[i]);
-                    }
-                }
-            } else {
-                // Внутреннее сжатие
-                std::vector<double> contracted = contract_point(simplex[n], centroid, rho);
-                double f_contracted = func(contracted);
+MultiStartResult neldermead_multistart(const std::vector<double>& x0, const std::vector<double>& lower,
+                                       const std::vector<double>& upper, const MultiStartOptions& options,
+                                       std::function<double(std::vector<double>)> func) {
+    size_t n = x0.size();
+    if (lower.size() != n || upper.size() != n) {
+        throw std::runtime_error("Мультистарт: границы области не совпадают по размерности с x0");
+    }
+    if (n > sizeof(HALTON_BASES) / sizeof(HALTON_BASES[0])) {
+        throw std::runtime_error("Мультистарт: слишком много параметров для плана Холтона");
+    }
+    if (options.starts < 1) {
+        throw std::runtime_error("Мультистарт: нужен хотя бы один запуск");
+    }
+    size_t k = size_t(options.starts);
 
-                if (f_contracted < f_values[n]) {
-                    simplex[n] = contracted;
-                    f_values[n] = f_contracted;
-                } else {
-                    // Уменьшение
-                    for (size_t i = 1; i <= n; ++i) {
-                        for (size_t j = 0; j < n; ++j) {
-                            simplex[i][j] = simplex[0][j] + sigma * (simplex[i][j] - simplex[0][j]);
-                        }
-                        f_values[i] = func(simplex[i]);
-                    }
-                }
-            }
+    // План: x0 и точки Холтона 1..K-1 в [lower, upper]
+    std::vector<std::vector<double>> points(k, x0);
+    for (size_t s = 1; s < k; s++) {
+        for (size_t j = 0; j < n; j++) {
+            points[s][j] = lower[j] + (upper[j] - lower[j]) * halton(s, HALTON_BASES[j]);
         }
     }
 
-    // Максимальное число итераций достигнуто
-    result.converged = false;
-    result.iterations = max_iter;
-    result.parameters = simplex[0];
-    result.final_value = f_values[0];
+    // Значения в точках плана: запуски - от лучших точек к худшим,
+    // общее лучшее значение известно еще до первого запуска
+    ThreadPool& pool = global_thread_pool();
+    std::vector<double> values(k);
+    pool.parallel_for(k, [&](size_t s) {
+        double v = func(points[s]);
+        values[s] = std::isnan(v) ? std::numeric_limits<double>::infinity() : v;
+    });
+    std::vector<size_t> order(k);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&values](size_t a, size_t b) { return values[a] < values[b]; });
+    MultiStartShared shared;
+    shared.value = values[order[0]];
+    shared.point = points[order[0]];
+
+    std::vector<NelderMeadResult> runs(k);
+    std::vector<char> abandoned(k, 0);
+    pool.parallel_for(k, [&](size_t t) {
+        size_t s = order[t];
+        MultiStartObserver observer(shared, options, lower, upper);
+        NelderMeadOptions local = options.local;
+        local.observer = &observer;
+        runs[s] = neldermead_detailed(points[s], local, func);
+        abandoned[s] = observer.abandoned;
+    });
+
+    // Лучший из доведенных до конца запусков (при равенстве - раньше в порядке запуска)
+    MultiStartResult result;
+    result.starts = int(k);
+    result.evaluations = int(k);
+    for (size_t t = 0; t < k; t++) {
+        size_t s = order[t];
+        result.evaluations += runs[s].counters.evaluations;
+        if (abandoned[s]) {
+            result.abandoned++;
+            continue;
+        }
+        if (runs[s].converged) result.converged++;
+        if (result.best_start < 0 || runs[s].final_value < result.best.final_value) {
+            result.best = runs[s];
+            result.best_start = int(s);
+        }
+    }
     return result;
-}
\ No newline at end of file
+}
+
+MultiStartResult neldermead_multistart(const std::vector<double>& x0, const std::vector<double>& lower,
+                                       const std::vector<double>& upper, const MultiStartOptions& options,
+                                       const FitContext& ctx,
+                                       std::function<double(const FitContext&, const std::vector<double>&)> func) {
+    return neldermead_multistart(x0, lower, upper, options,
+                                 [&ctx, &func](std::vector<double> x) { return func(ctx, x); });
+}
@@ -0,0 +1,589 @@
+#include "nelder_mead_batch.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+// ============ Векторные типы ============
+// Одна переменная - значения всех дорожек. Тела ядер компилируются трижды
+// (AVX-512, AVX2+FMA и базовый набор команд) и выбираются при первом вызове.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_SIMD_X86 1
+#endif
+
+static const size_t L = NELDER_MEAD_BATCH_LANES;
+
+typedef double batch_vd __attribute__((vector_size(L * sizeof(double))));
+typedef long long batch_vi __attribute__((vector_size(L * sizeof(long long))));
+
+// Векторы передаются по ссылке: соглашение о передаче 64-байтовых векторов
+// по значению различается с AVX-512 и без него
+#define BATCH_INLINE static inline __attribute__((always_inline))
+
+BATCH_INLINE void batch_load(batch_vd& v, const double* p) {
+    std::memcpy(&v, p, sizeof(v));
+}
+
+BATCH_INLINE void batch_load(batch_vi& v, const long long* p) {
+    std::memcpy(&v, p, sizeof(v));
+}
+
+BATCH_INLINE void batch_store(double* p, const batch_vd& v) {
+    std::memcpy(p, &v, sizeof(v));
+}
+
+/**
+ * e = exp(t) по дорожкам: t = n ln2 + r (Коди-Уэйт, |r| <= ln2 / 2), e^r - ряд
+ * Тейлора до r^13 (погрешность ~1 ulp), 2^n - сборкой порядка. n округляется
+ * прибавлением 1.5 * 2^52: младшие биты суммы - это n в дополнительном коде.
+ * t > 709 - +inf, t < -708 - 0 (без денормализованных чисел).
+ */
+BATCH_INLINE void batch_exp(const batch_vd& t, batch_vd& e) {
+    const double magic = 6755399441055744.0;          // 1.5 * 2^52
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    const batch_vd hi = batch_vd{} + 709.0;
+    const batch_vd lo = batch_vd{} - 708.0;
+
+    batch_vd u = t > hi ? hi : t;
+    u = u < lo ? lo : u;
+    batch_vd y = u * 1.44269504088896340736 + magic;
+    batch_vd n = y - magic;
+    batch_vd r = (u - n * ln2_hi) - n * ln2_lo;
+
+    static const double c[14] = {
+        1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+        1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800,
+        1.0 / 479001600, 1.0 / 6227020800.0
+    };
+    batch_vd p = batch_vd{} + c[13];
+    for (int k = 12; k >= 0; k--) p = p * r + c[k];
+
+    const batch_vd magic_v = batch_vd{} + magic;
+    batch_vi k = (batch_vi)y - (batch_vi)magic_v;
+    batch_vd scale = (batch_vd)((k + 1023) << 52);
+    e = p * scale;
+    e = t > hi ? batch_vd{} + std::numeric_limits<double>::infinity() : e;
+    e = t < lo ? batch_vd{} : e;
+}
+
+// ============ Ядра ============
+// Сумма по наблюдениям i < rows, отмеченным в mask (-1); остальные (цензурированные,
+// дополнение до rows) отбрасываются выбором, а не умножением на 0, поэтому сумма
+// дорожки не зависит от данных соседних дорожек и от rows.
+
+/**
+ * Нормальная модель: sum ((x - μ) / σ)^2 по полным наблюдениям
+ */
+BATCH_INLINE void normal_sums_body(const double* x, const long long* mask, size_t rows,
+                                   const double* mu, const double* inv_sigma, double* out) {
+    batch_vd m, s, v, acc = {};
+    batch_vi use;
+    batch_load(m, mu);
+    batch_load(s, inv_sigma);
+    for (size_t i = 0; i < rows; i++) {
+        batch_load(v, x + i * L);
+        batch_load(use, mask + i * L);
+        batch_vd z = (v - m) * s;
+        acc = use != 0 ? acc + z * z : acc;
+    }
+    batch_store(out, acc);
+}
+
+/**
+ * Вейбулл: sum exp(k (ln x - ln λ)) = sum (x / λ)^k по всем наблюдениям
+ */
+BATCH_INLINE void weibull_sums_body(const double* log_x, const long long* mask, size_t rows,
+                                    const double* log_lambda, const double* shape, double* out) {
+    batch_vd ll, k, v, e, acc = {};
+    batch_vi use;
+    batch_load(ll, log_lambda);
+    batch_load(k, shape);
+    for (size_t i = 0; i < rows; i++) {
+        batch_load(v, log_x + i * L);
+        batch_load(use, mask + i * L);
+        batch_exp(k * (v - ll), e);
+        acc = use != 0 ? acc + e : acc;
+    }
+    batch_store(out, acc);
+}
+
+typedef void (*BatchSums)(const double*, const long long*, size_t, const double*, const double*, double*);
+
+static void normal_sums_generic(const double* x, const long long* mask, size_t rows,
+                                const double* a, const double* b, double* out) {
+    normal_sums_body(x, mask, rows, a, b, out);
+}
+
+static void weibull_sums_generic(const double* x, const long long* mask, size_t rows,
+                                 const double* a, const double* b, double* out) {
+    weibull_sums_body(x, mask, rows, a, b, out);
+}
+
+#ifdef BATCH_SIMD_X86
+__attribute__((target("avx2,fma")))
+static void normal_sums_avx2(const double* x, const long long* mask, size_t rows,
+                             const double* a, const double* b, double* out) {
+    normal_sums_body(x, mask, rows, a, b, out);
+}
+
+__attribute__((target("avx2,fma")))
+static void weibull_sums_avx2(const double* x, const long long* mask, size_t rows,
+                              const double* a, const double* b, double* out) {
+    weibull_sums_body(x, mask, rows, a, b, out);
+}
+
+__attribute__((target("avx512f")))
+static void normal_sums_avx512(const double* x, const long long* mask, size_t rows,
+                               const double* a, const double* b, double* out) {
+    normal_sums_body(x, mask, rows, a, b, out);
+}
+
+__attribute__((target("avx512f")))
+static void weibull_sums_avx512(const double* x, const long long* mask, size_t rows,
+                                const double* a, const double* b, double* out) {
+    weibull_sums_body(x, mask, rows, a, b, out);
+}
+#endif
+
+struct BatchKernels {
+    const char* name;
+    BatchSums normal;
+    BatchSums weibull;
+};
+
+static BatchKernel batch_kernel_requested = BATCH_KERNEL_AUTO;
+
+void neldermead_batch_set_kernel(BatchKernel kernel) {
+    batch_kernel_requested = kernel;
+}
+
+BatchKernel neldermead_batch_active_kernel() {
+#ifdef BATCH_SIMD_X86
+    bool has_avx512 = __builtin_cpu_supports("avx512f");
+    bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+
+    switch (batch_kernel_requested) {
+        case BATCH_KERNEL_GENERIC:
+            return BATCH_KERNEL_GENERIC;
+        case BATCH_KERNEL_AVX512:
+            if (has_avx512) return BATCH_KERNEL_AVX512;
+            break;
+        case BATCH_KERNEL_AVX2:
+            if (has_avx2) return BATCH_KERNEL_AVX2;
+            return BATCH_KERNEL_GENERIC;
+        case BATCH_KERNEL_AUTO:
+            break;
+    }
+    if (has_avx512) return BATCH_KERNEL_AVX512;
+    if (has_avx2) return BATCH_KERNEL_AVX2;
+#endif
+    return BATCH_KERNEL_GENERIC;
+}
+
+static BatchKernels select_kernels() {
+    switch (neldermead_batch_active_kernel()) {
+#ifdef BATCH_SIMD_X86
+        case BATCH_KERNEL_AVX512: return {"avx512", normal_sums_avx512, weibull_sums_avx512};
+        case BATCH_KERNEL_AVX2:   return {"avx2", normal_sums_avx2, weibull_sums_avx2};
+#endif
+        default:                  return {"generic", normal_sums_generic, weibull_sums_generic};
+    }
+}
+
+// ============ Данные по дорожкам ============
+
+/**
+ * Выборки, загруженные на дорожки: наблюдение i дорожки l - элемент i * L + l.
+ * Для нормальной модели хранится x и отмечены полные наблюдения,
+ * для Вейбулла - ln x и отмечены все наблюдения.
+ */
+struct BatchColumns {
+    size_t rows = 0;
+    std::vector<double> value;
+    std::vector<long long> mask;
+    double complete[L] = {};            // число полных наблюдений
+    double log_sum[L] = {};             // sum ln x по полным наблюдениям (Вейбулл)
+    std::vector<double> censored[L];    // цензурированные x (нормальная модель)
+
+    BatchColumns(size_t rows) : rows(rows), value(rows * L, 0.0), mask(rows * L, 0) {}
+
+    void load(size_t lane, BatchModel model, const FitContext& ctx) {
+        size_t n = size_t(ctx.n);
+        complete[lane] = 0.0;
+        log_sum[lane] = 0.0;
+        censored[lane].clear();
+        for (size_t i = 0; i < rows; i++) {
+            double v = 0.0;
+            bool use = false;
+            if (i < n) {
+                bool cens = ctx.censored(int(i)) != 0;
+                if (model == BATCH_MODEL_WEIBULL) {
+                    v = std::log(ctx.x[i]);
+                    use = true;
+                    if (!cens) log_sum[lane] += v;
+                } else {
+                    v = ctx.x[i];
+                    use = !cens;
+                    if (cens) censored[lane].push_back(v);
+                }
+                if (!cens) complete[lane] += 1.0;
+            }
+            value[i * L + lane] = v;
+            mask[i * L + lane] = use ? -1 : 0;
+        }
+    }
+
+    void clear(size_t lane) {
+        for (size_t i = 0; i < rows; i++) mask[i * L + lane] = 0;
+        censored[lane].clear();
+    }
+};
+
+// ============ Задача на дорожке ============
+// neldermead_core, разрезанный на шаги по одному вычислению функции: задача
+// сообщает точку, ждущую значения, и продолжает, когда значение готово.
+// Последовательность точек и значений та же, что у neldermead<2>.
+
+typedef std::array<double, 2> BatchPoint;
+static const size_t BATCH_N = 2;
+
+enum BatchStep {
+    BATCH_STEP_INIT,            // вершина vertex начального симплекса
+    BATCH_STEP_REFLECT,
+    BATCH_STEP_EXPAND,
+    BATCH_STEP_CONTRACT_OUTSIDE,
+    BATCH_STEP_CONTRACT_INSIDE,
+    BATCH_STEP_SHRINK           // вершина vertex после уменьшения
+};
+
+struct BatchLane {
+    long problem = -1;          // индекс выборки, -1 - дорожка свободна
+    BatchStep step = BATCH_STEP_INIT;
+    size_t vertex = 0;
+    BatchPoint simplex[BATCH_N + 1];
+    double f_values[BATCH_N + 1];
+    BatchPoint centroid, reflected, trial;
+    double f_reflected = 0.0;
+    const BatchPoint* request = nullptr;
+    NelderMeadFixedResult<2> result;
+
+    void start(long index, const BatchPoint& x0) {
+        problem = index;
+        result = NelderMeadFixedResult<2>();
+        for (size_t i = 0; i <= BATCH_N; i++) simplex[i] = x0;
+        for (size_t i = 1; i <= BATCH_N; i++) {
+            simplex[i][i - 1] += 0.1 * (simplex[0][i - 1] != 0.0 ? simplex[0][i - 1] : 1.0);
+        }
+        step = BATCH_STEP_INIT;
+        vertex = 0;
+        request = &simplex[0];
+    }
+
+    /**
+     * Начало итерации: упорядочение, проверка сходимости, отражение.
+     * @return true - задача завершена
+     */
+    bool iterate(const NelderMeadOptions& options) {
+        const double alpha = 1.0;
+        const size_t n = BATCH_N;
+        if (result.iterations >= options.max_iter) return finish(false);
+        result.iterations++;
+
+        for (size_t i = 1; i <= n; ++i) {
+            for (size_t j = i; j > 0 && f_values[j] < f_values[j - 1]; --j) {
+                std::swap(f_values[j], f_values[j - 1]);
+                std::swap(simplex[j], simplex[j - 1]);
+            }
+        }
+
+        double size = 0.0;
+        for (size_t j = 0; j < n; ++j) {
+            double lo = simplex[0][j], hi = simplex[0][j];
+            for (size_t i = 1; i <= n; ++i) {
+                lo = std::min(lo, simplex[i][j]);
+                hi = std::max(hi, simplex[i][j]);
+            }
+            size = std::max(size, hi - lo);
+        }
+        if (size < options.eps) return finish(true);
+
+        for (size_t j = 0; j < n; ++j) {
+            double c = 0.0;
+            for (size_t i = 0; i < n; ++i) c += simplex[i][j];
+            centroid[j] = c / n;
+        }
+        for (size_t j = 0; j < n; ++j) reflected[j] = centroid[j] + alpha * (centroid[j] - simplex[n][j]);
+        step = BATCH_STEP_REFLECT;
+        request = &reflected;
+        return false;
+    }
+
+    /**
+     * Значение в запрошенной точке; задача переходит к следующей точке.
+     * @return true - задача завершена
+     */
+    bool advance(double value, const NelderMeadOptions& options) {
+        const double gamma = 2.0;
+        const double rho = 0.5;
+        const double sigma = 0.5;
+        const size_t n = BATCH_N;
+        result.counters.evaluations++;
+
+        switch (step) {
+            case BATCH_STEP_INIT:
+            case BATCH_STEP_SHRINK:
+                f_values[vertex] = value;
+                if (++vertex <= n) {
+                    request = &simplex[vertex];
+                    return false;
+                }
+                return iterate(options);
+
+            case BATCH_STEP_REFLECT:
+                f_reflected = value;
+                if (f_reflected < f_values[0]) {
+                    for (size_t j = 0; j < n; ++j) trial[j] = centroid[j] + gamma * (reflected[j] - centroid[j]);
+                    step = BATCH_STEP_EXPAND;
+                } else if (f_reflected < f_values[n - 1]) {
+                    simplex[n] = reflected;
+                    f_values[n] = f_reflected;
+                    result.counters.reflections++;
+                    return iterate(options);
+                } else if (f_reflected < f_values[n]) {
+                    for (size_t j = 0; j < n; ++j) trial[j] = centroid[j] + rho * (reflected[j] - centroid[j]);
+                    step = BATCH_STEP_CONTRACT_OUTSIDE;
+                } else {
+                    for (size_t j = 0; j < n; ++j) trial[j] = centroid[j] + rho * (simplex[n][j] - centroid[j]);
+                    step = BATCH_STEP_CONTRACT_INSIDE;
+                }
+                request = &trial;
+                return false;
+
+            case BATCH_STEP_EXPAND:
+                if (value < f_reflected) {
+                    simplex[n] = trial;
+                    f_values[n] = value;
+                    result.counters.expansions++;
+                } else {
+                    simplex[n] = reflected;
+                    f_values[n] = f_reflected;
+                    result.counters.reflections++;
+                }
+                return iterate(options);
+
+            case BATCH_STEP_CONTRACT_OUTSIDE:
+            case BATCH_STEP_CONTRACT_INSIDE:
+                if (value < (step == BATCH_STEP_CONTRACT_OUTSIDE ? f_reflected : f_values[n])) {
+                    simplex[n] = trial;
+                    f_values[n] = value;
+                    result.counters.contractions++;
+                    return iterate(options);
+                }
+                // Уменьшение к лучшей вершине
+                result.counters.shrinks++;
+                for (size_t i = 1; i <= n; ++i) {
+                    for (size_t j = 0; j < n; ++j) {
+                        simplex[i][j] = simplex[0][j] + sigma * (simplex[i][j] - simplex[0][j]);
+                    }
+                }
+                step = BATCH_STEP_SHRINK;
+                vertex = 1;
+                request = &simplex[1];
+                return false;
+        }
+        return false;
+    }
+
+    bool finish(bool converged) {
+        result.converged = converged;
+        result.parameters = simplex[0];
+        result.final_value = f_values[0];
+        request = nullptr;
+        return true;
+    }
+};
+
+// ============ Целевая функция по дорожкам ============
+
+static const double BATCH_LOG_SQRT_2PI = 0.91893853320467274178;
+
+/**
+ * -log L в точках, запрошенных задачами; свободные дорожки и точки вне области
+ * параметров получают нейтральные параметры для ядра и +inf в out
+ */
+static void batch_evaluate(BatchModel model, const BatchKernels& kernels, const BatchColumns& columns,
+                           const BatchLane* lanes, double* out) {
+    const double inf = std::numeric_limits<double>::infinity();
+    double a[L], b[L], sums[L];
+    bool valid[L];
+    for (size_t l = 0; l < L; l++) {
+        a[l] = 0.0;
+        b[l] = 1.0;
+        valid[l] = false;
+        if (lanes[l].request == nullptr) continue;
+        const BatchPoint& p = *lanes[l].request;
+        if (!(p[1] > 0.0) || (model == BATCH_MODEL_WEIBULL && !(p[0] > 0.0))) continue;
+        valid[l] = true;
+        if (model == BATCH_MODEL_WEIBULL) {
+            a[l] = std::log(p[0]);
+            b[l] = p[1];
+        } else {
+            a[l] = p[0];
+            b[l] = 1.0 / p[1];
+        }
+    }
+
+    const BatchSums sums_kernel = (model == BATCH_MODEL_WEIBULL) ? kernels.weibull : kernels.normal;
+    sums_kernel(columns.value.data(), columns.mask.data(), columns.rows, a, b, sums);
+
+    for (size_t l = 0; l < L; l++) {
+        if (!valid[l]) {
+            out[l] = inf;
+            continue;
+        }
+        const double k = columns.complete[l];
+        double v;
+        if (model == BATCH_MODEL_WEIBULL) {
+            // -sum_полн [ln k - k ln λ + (k - 1) ln x] + sum_все (x / λ)^k
+            v = -k * std::log(b[l]) + k * b[l] * a[l] - (b[l] - 1.0) * columns.log_sum[l] + sums[l];
+        } else {
+            // полные: ln σ + ln sqrt(2π) + z^2 / 2; цензурированные: -ln Q(z)
+            const double sigma = (*lanes[l].request)[1];
+            v = 0.5 * sums[l] + k * (std::log(sigma) + BATCH_LOG_SQRT_2PI);
+            for (double x : columns.censored[l]) {
+                v -= std::log(0.5 * std::erfc((x - a[l]) * b[l] * M_SQRT1_2));
+            }
+        }
+        out[l] = std::isnan(v) ? inf : v;
+    }
+}
+
+// ============ Пакетная подгонка ============
+
+/**
+ * Выборки order[begin, end) на одном наборе дорожек
+ */
+static void batch_run(BatchModel model, const BatchKernels& kernels,
+                      const std::vector<FitContext>& lots, const std::vector<BatchPoint>& x0,
+                      const NelderMeadOptions& options, const std::vector<size_t>& order,
+                      size_t begin, size_t end, std::vector<NelderMeadFixedResult<2>>& results,
+                      NelderMeadBatchReport& report) {
+    size_t rows = 0;
+    for (size_t t = begin; t < end; t++) rows = std::max(rows, size_t(lots[order[t]].n));
+    BatchColumns columns(rows);
+    BatchLane lanes[L];
+    size_t next = begin;
+
+    // Загрузка следующей выборки на дорожку l (или освобождение дорожки)
+    auto refill = [&](size_t l) {
+        if (next < end) {
+            size_t s = order[next++];
+            columns.load(l, model, lots[s]);
+            lanes[l].start(long(s), x0[s]);
+        } else {
+            columns.clear(l);
+            lanes[l].problem = -1;
+            lanes[l].request = nullptr;
+        }
+    };
+    for (size_t l = 0; l < L; l++) refill(l);
+
+    double values[L];
+    while (true) {
+        long long active = 0;
+        for (size_t l = 0; l < L; l++) active += (lanes[l].problem >= 0);
+        if (active == 0) break;
+
+        batch_evaluate(model, kernels, columns, lanes, values);
+        report.vector_evaluations++;
+        report.lane_evaluations += active;
+
+        // Завершенная задача освобождает дорожку: первая точка следующей
+        // вычисляется уже на следующем шаге
+        for (size_t l = 0; l < L; l++) {
+            if (lanes[l].problem >= 0 && lanes[l].advance(values[l], options)) {
+                results[size_t(lanes[l].problem)] = lanes[l].result;
+                refill(l);
+            }
+        }
+    }
+}
+
+/**
+ * Проверка выборок; для Вейбулла наблюдения должны быть положительны
+ */
+static void batch_check_lot(BatchModel model, const FitContext& ctx) {
+    if (ctx.n < 0 || (ctx.n > 0 && ctx.x == nullptr)) {
+        throw std::runtime_error("Пустые данные выборки в пакетной подгонке");
+    }
+    if (model == BATCH_MODEL_WEIBULL) {
+        for (int i = 0; i < ctx.n; i++) {
+            if (!(ctx.x[i] > 0.0)) {
+                throw std::runtime_error("Наблюдения для распределения Вейбулла должны быть положительны");
+            }
+        }
+    }
+}
+
+double neldermead_batch_value(BatchModel model, const FitContext& ctx, const std::array<double, 2>& x) {
+    batch_check_lot(model, ctx);
+
+    // Выборка на дорожке 0, остальные дорожки свободны
+    BatchColumns columns(size_t(ctx.n));
+    columns.load(0, model, ctx);
+    BatchLane lanes[L];
+    lanes[0].request = &x;
+
+    double values[L];
+    batch_evaluate(model, select_kernels(), columns, lanes, values);
+    return values[0];
+}
+
+std::vector<NelderMeadFixedResult<2>> neldermead_batch(
+    BatchModel model,
+    const std::vector<FitContext>& lots,
+    const std::vector<std::array<double, 2>>& x0,
+    const NelderMeadOptions& options,
+    NelderMeadBatchReport* report
+) {
+    if (x0.size() != lots.size()) {
+        throw std::runtime_error("Число начальных точек не совпадает с числом выборок");
+    }
+    for (const FitContext& ctx : lots) batch_check_lot(model, ctx);
+
+    const BatchKernels kernels = select_kernels();
+
+    // Выборки близкого размера - на одних дорожках: меньше дополнения до rows
+    std::vector<size_t> order(lots.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&lots](size_t a, size_t b) { return lots[a].n < lots[b].n; });
+
+    // Части по BATCH_CHUNK_ROUNDS выборок на дорожку - по потокам пула
+    const size_t BATCH_CHUNK_ROUNDS = 8;
+    const size_t chunk = L * BATCH_CHUNK_ROUNDS;
+    const size_t chunks = (lots.size() + chunk - 1) / chunk;
+
+    std::vector<NelderMeadFixedResult<2>> results(lots.size());
+    std::vector<NelderMeadBatchReport> reports(chunks);
+    global_thread_pool().parallel_for(chunks, [&](size_t c) {
+        size_t begin = c * chunk;
+        size_t end = std::min(lots.size(), begin + chunk);
+        batch_run(model, kernels, lots, x0, options, order, begin, end, results, reports[c]);
+    });
+
+    if (report != nullptr) {
+        *report = NelderMeadBatchReport();
+        report->kernel = kernels.name;
+        for (const NelderMeadBatchReport& r : reports) {
+            report->vector_evaluations += r.vector_evaluations;
+            report->lane_evaluations += r.lane_evaluations;
+        }
+    }
+    return results;
+}
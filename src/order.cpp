@@ -1,58 +1,171 @@
 #include "order.h"
 #include "boost_distributions.h"
+#include "thread_pool.h"
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <stdexcept>
 #include <numeric>
 
 // Агамировские функции для вычисления математического ожидания и ковариации
 // порядковых статистик нормального распределения
 
-// ============ ordern - для нормального распределения ============
-// Вычисляет математическое ожидание (er) и ковариацию (vrs) порядковых статистик
-// n - размер выборки
-// pr, ps - вероятности (r/(n+1), s/(n+1))
-void ordern(int n, double pr, double ps, double& er, double& vrs) {
-    double p, pr1, ps1, xr, xr1, xr2, xr3, xr4, xr5, xr6, dr, qr, qs;
-    double xs1, xs2, xs3, xs4, xs5, xs6, ds, xs;
+// ============ Порядок разложения ============
+
+static int order_expansion_requested = ORDER_EXPANSION_MAX;
+
+void order_set_expansion(int order) {
+    if (order < 1 || order > ORDER_EXPANSION_MAX) {
+        throw std::runtime_error("Порядок разложения Дэйвида-Джонсона должен быть от 1 до 3");
+    }
+    order_expansion_requested = order;
+}
+
+int order_expansion() {
+    return order_expansion_requested;
+}
+
+// Члены порядка (n+2)^{-k} используют производные до x^{(2k)} (ожидание)
+// и до x^{(2k-1)} (ковариация), поэтому старшие производные при усечении не нужны
+static int order_derivative_count(int order) {
+    return 2 * order;
+}
+
+// ============ Производные квантильной функции ============
+
+// Нормальное распределение: x^{(k)}(p) = P_k(x) / φ(x)^k, где
+//   P_1 = 1,  P_{k+1}(x) = P_k'(x) + k x P_k(x)
+// (P_3 = 2x²+1, P_4 = 6x³+7x, P_5 = 24x⁴+46x²+7, P_6 = 120x⁵+326x³+127x).
+// Коэффициенты строятся рекуррентно на этапе компиляции.
+struct NormalDerivativePolys {
+    double c[ORDER_EXPANSION_MAX * 2 + 1][ORDER_EXPANSION_MAX * 2 + 1];   // c[k][j] - при x^j в P_k
+};
+
+static constexpr NormalDerivativePolys make_normal_derivative_polys() {
+    NormalDerivativePolys poly{};
+    const int kmax = ORDER_EXPANSION_MAX * 2;
+    poly.c[1][0] = 1.;
+    for (int k = 1; k < kmax; k++) {
+        for (int j = 1; j <= kmax; j++) {
+            poly.c[k + 1][j - 1] += j * poly.c[k][j];      // P_k'
+            poly.c[k + 1][j] += k * poly.c[k][j - 1];      // k x P_k
+        }
+    }
+    return poly;
+}
+
+static constexpr NormalDerivativePolys NORMAL_DERIVATIVE_POLYS = make_normal_derivative_polys();
+
+static_assert(NORMAL_DERIVATIVE_POLYS.c[6][5] == 120. && NORMAL_DERIVATIVE_POLYS.c[6][3] == 326. &&
+              NORMAL_DERIVATIVE_POLYS.c[6][1] == 127., "коэффициенты P_6");
+
+// P_k(x) по схеме Горнера от x²: P_k содержит степени одной четности (k - 1)
+static inline double normal_derivative_poly(int k, double x, double xx) {
+    const double* c = NORMAL_DERIVATIVE_POLYS.c[k];
+    int j = k - 1;
+    double v = c[j];
+    for (j -= 2; j >= 0; j -= 2) {
+        v = v * xx + c[j];
+    }
+    return ((k - 1) % 2 == 0) ? v : v * x;
+}
+
+OrderTerms order_terms_normal(double p, int order) {
+    OrderTerms t;
+    double* dx[6] = {&t.x1, &t.x2, &t.x3, &t.x4, &t.x5, &t.x6};
+    int count = order_derivative_count(order);
+
+    t.p = p;
+    t.q = 1. - p;
+    t.x = norm_ppf(p);
+
+    // Общие степени: x² для полиномов и (1/φ)^k нарастающим произведением
+    double u = 1. / norm_pdf(t.x);
+    double xx = t.x * t.x;
+    double uk = u;
+    for (int k = 1; k <= 6; k++) {
+        *dx[k - 1] = (k <= count) ? normal_derivative_poly(k, t.x, xx) * uk : 0.0;
+        uk *= u;
+    }
+    return t;
+}
+
+// Распределение Вейбулла (логарифмическая шкала): x(p) = ln(-ln(1-p))
+OrderTerms order_terms_weibull(double p, int order) {
+    OrderTerms t;
+    int count = order_derivative_count(order);
+
+    t.p = p;
+    t.q = 1. - p;
+    t.x2 = t.x3 = t.x4 = t.x5 = t.x6 = 0.0;
+
+    // Общие степени 1/(1-p)
+    double iq = 1. / (1. - p);
+    double iq2 = iq * iq, iq3 = iq2 * iq, iq4 = iq3 * iq, iq5 = iq4 * iq;
+
+    t.x = log(log(iq));
+    t.x1 = 1. / (log(iq) * (1. - p));
+    t.x2 = t.x1 * (iq - t.x1);
+    if (count <= 2) return t;
+
+    double x1sq = t.x1 * t.x1, x2sq = t.x2 * t.x2, x2cu = x2sq * t.x2;
+    t.x3 = x2sq / t.x1 + t.x1 * (iq2 - t.x2);
+    t.x4 = (3. * t.x1 * t.x2 * t.x3 - 2. * x2cu) / x1sq + t.x1 * (2. * iq3 - t.x3);
+    if (count <= 4) return t;
+
+    double x1cu = x1sq * t.x1;
+    double x55 = (-12. * t.x1 * x2sq * t.x3 + 3. * x1sq * t.x3 * t.x3 +
+                  4. * x1sq * t.x2 * t.x4 + 6. * x2sq * x2sq);
+    t.x5 = x55 / x1cu + t.x1 * (6. * iq4 - t.x4);
+
+    double a1 = -12. * x2cu * t.x3 - 12. * t.x1 * (2. * t.x2 * t.x3 * t.x3 + x2sq * t.x4);
+    double b1 = 6. * t.x1 * t.x2 * t.x3 * t.x3 + 6. * x1sq * t.x3 * t.x4;
+    double c1 = 8. * t.x1 * x2sq * t.x4 + 4. * x1sq * (t.x3 * t.x4 + t.x2 * t.x5);
+    double d1 = 24. * x2cu * t.x3;
+    t.x6 = (x1cu * (a1 + b1 + c1 + d1) - 3. * x1sq * t.x2 * x55) / (x1cu * x1cu) +
+           t.x2 * (6. * iq4 - t.x4) + t.x1 * (24. * iq5 - t.x5);
+    return t;
+}
+
+// ============ Разложение Дэйвида-Джонсона ============
+// Формулы одинаковы для обоих распределений - отличаются только производные.
+// Слагаемые сгруппированы по степеням 1/(n+2) и суммируются до порядка order.
+
+// Математическое ожидание r-ой порядковой статистики
+double order_expectation(int n, const OrderTerms& r, int order) {
+    double pr = r.p, qr = r.q;
+    double e = r.x;
+
+    if (order >= 1) {
+        e += pr * qr * r.x2 / (2. * (n + 2.));
+    }
+    if (order >= 2) {
+        e += pr * qr * ((qr - pr) * r.x3 / 3. + pr * qr * r.x4 / 8.) / pow((n + 2.), 2);
+    }
+    if (order >= 3) {
+        e += pr * qr * (-(qr - pr) * r.x3 / 3. + (pow((qr - pr), 2) - pr * qr) * r.x4 / 4. +
+                        qr * pr * (qr - pr) * r.x5 / 6. + pow((qr * pr), 2) * r.x6 / 48.) / pow((n + 2.), 3);
+    }
+    return e;
+}
+
+// Ковариация r-ой и s-ой порядковых статистик
+double order_covariance(int n, const OrderTerms& r, const OrderTerms& s, int order) {
+    double pr = r.p, qr = r.q, ps = s.p, qs = s.q;
+    double xr1 = r.x1, xr2 = r.x2, xr3 = r.x3, xr4 = r.x4, xr5 = r.x5;
+    double xs1 = s.x1, xs2 = s.x2, xs3 = s.x3, xs4 = s.x4, xs5 = s.x5;
     double z1, z2, z3, z4, z5, z6, z7;
 
-    p = 1;
-    xr = norm_ppf(pr);
-    xs = norm_ppf(ps);
-    qr = 1. - pr;
-    qs = 1. - ps;
-    pr1 = pr * p;
-    ps1 = ps * p;
-
-    dr = norm_pdf(xr);
-    ds = norm_pdf(xs);
-
-    xr1 = p / dr;
-    xr2 = xr * xr1 * xr1;
-    xr3 = (2. * xr * xr + 1.) * pow((p / dr), 3);
-    xr4 = (6. * xr * xr * xr + 7. * xr) * pow((p / dr), 4);
-    xr5 = (24. * pow(xr, 4) + 46. * xr * xr + 7.) * pow((p / dr), 5);
-    xr6 = (120. * pow(xr, 5) + 326. * xr * xr * xr + 127. * xr) * pow((p / dr), 6);
-
-    xs1 = p / ds;
-    xs2 = xs * xs1 * xs1;
-    xs3 = (2. * xs * xs + 1.) * pow((p / ds), 3);
-    xs4 = (6. * xs * xs * xs + 7. * xs) * pow((p / ds), 4);
-    xs5 = (24. * pow(xs, 4) + 46. * xs * xs + 7.) * pow((p / ds), 5);
-    xs6 = (120. * pow(xs, 5) + 326. * xs * xs * xs + 127. * xs) * pow(p / ds, 6);
-
-    // Математическое ожидание r-ой порядковой статистики
-    er = xr + pr * qr * xr2 / (2. * (n + 2.)) +
-         pr * qr * ((qr - pr) * xr3 / 3. + pr * qr * xr4 / 8.) / pow((n + 2.), 2) +
-         pr * qr * (-(qr - pr) * xr3 / 3. + (pow((qr - pr), 2) - pr * qr) * xr4 / 4. +
-                    qr * pr * (qr - pr) * xr5 / 6. + pow((qr * pr), 2) * xr6 / 48.) / pow((n + 2.), 3);
-
-    // Ковариация r-ой и s-ой порядковых статистик
+    double lead = pr * qs * xr1 * xs1 / (n + 2.);
+    if (order <= 0) return 0.0;
+    if (order == 1) return lead;
+
     z1 = (qr - pr) * xr2 * xs1 + (qs - ps) * xr1 * xs2 + pr * qr * xr3 * xs1 / 2. +
          ps * qs * xr1 * xs3 / 2. + pr * qs * xr2 * xs2 / 2.;
     z1 = z1 * pr * qs / pow((n + 2.), 2);
+    if (order == 2) return z1 + lead;
 
     z2 = -(qr - pr) * xr2 * xs1 - (qs - ps) * xr1 * xs2 + (pow((qr - pr), 2) - pr * qr) * xr3 * xs1;
     z3 = (pow((qs - ps), 2) - ps * qs) * xr1 * xs3 + (1.5 * (qr - pr) * (qs - ps) + 0.5 * ps * qr - 2. * pr * qs) * xr2 * xs2;
@@ -64,82 +177,460 @@ void ordern(int n, double pr, double ps, double& er, double& vrs) {
          (2. * (pr * pr * qs * qs) + 3. * pr * qr * ps * qs) * xr3 * xs3 / 12.;
     z7 = z2 + z3 + z4 + z5 + z6;
 
-    vrs = z1 + pr * qs * z7 / pow((n + 2.), 3) + pr * qs * xr1 * xs1 / (n + 2.);
+    return z1 + pr * qs * z7 / pow((n + 2.), 3) + lead;
+}
+
+// Оценка погрешности усечения для одного индекса - модуль последнего учтенного
+// члена (для ожидания и дисперсии), как для асимптотического ряда. У крайних
+// порядковых статистик p q x^{(k)} не убывает с ростом n, поэтому оценка
+// определяется хвостами выборки, а не только величиной 1/(n+2).
+double order_truncation_error(int n, const OrderTerms& t, int order) {
+    double de = order_expectation(n, t, order) - order_expectation(n, t, order - 1);
+    double dv = order_covariance(n, t, t, order) - order_covariance(n, t, t, order - 1);
+    return std::max(std::abs(de), std::abs(dv));
+}
+
+// ============ ordern - для нормального распределения ============
+// Вычисляет математическое ожидание (er) и ковариацию (vrs) порядковых статистик
+// n - размер выборки
+// pr, ps - вероятности (r/(n+1), s/(n+1))
+void ordern(int n, double pr, double ps, double& er, double& vrs) {
+    int order = order_expansion();
+    OrderTerms tr = order_terms_normal(pr, order);
+    OrderTerms ts = order_terms_normal(ps, order);
+
+    er = order_expectation(n, tr, order);
+    vrs = order_covariance(n, tr, ts, order);
 }
 
 // ============ orderw - для распределения Вейбулла ============
 // Вычисляет математическое ожидание и ковариацию порядковых статистик
 // для распределения Вейбулла (в логарифмической шкале)
 void orderw(int n, double pr, double ps, double &er, double &vrs) {
-    double  qr, qs, xr, xr1, xr2, xr3, xr4, xr5, xr55, xr6;
-    double xs1, xs2, xs3, xs4, xs5;
-    double z1, z2, z3, z4, z5, z6, z7, a1, b1, c1, d1;
-
-    xr = log(log(1. / (1. - pr)));
-    qr = 1. - pr;
-    qs = 1. - ps;
-    xr1 = 1. / (log(1. / (1. - pr)) * (1. - pr));
-    xr2 = xr1 * (1. / (1. - pr) - xr1);
-    xr3 = xr2 * xr2 / xr1 + xr1 * (1. / pow((1. - pr), 2) - xr2);
-    xr4 = (3. * xr1 * xr2 * xr3 - 2. * pow(xr2, 3)) / pow(xr1, 2) + xr1 * (2. / pow((1. - pr), 3) - xr3);
-    xr55 = (-12. * xr1 * xr2 * xr2 * xr3 + 3. * xr1 * xr1 * xr3 * xr3 + 4. * xr1 * xr1 * xr2 * xr4 + 6. * pow(xr2, 4));
-    xr5 = xr55 / pow(xr1, 3) + xr1 * (6. / pow(1. - pr, 4) - xr4);
-    a1 = -12. * pow(xr2, 3) * xr3 - 12. * xr1 * (2. * xr2 * xr3 * xr3 + xr2 * xr2 * xr4);
-    b1 = 6. * xr1 * xr2 * xr3 * xr3 + 6. * xr1 * xr1 * xr3 * xr4;
-    c1 = 8. * xr1 * xr2 * xr2 * xr4 + 4. * xr1 * xr1 * (xr3 * xr4 + xr2 * xr5);
-    d1 = 24. * pow(xr2, 3) * xr3;
-    xr6 = (pow(xr1, 3) * (a1 + b1 + c1 + d1) - 3. * xr1 * xr1 * xr2 * xr55) / pow(xr1, 6) +
-          xr2 * (6. / pow((1. - pr), 4) - xr4) + xr1 * (24. / pow((1. - pr), 5) - xr5);
-
-    xs1 = 1. / (log(1. / (1. - ps)) * (1. - ps));
-    xs2 = xs1 * (1. / (1. - ps) - xs1);
-    xs3 = xs2 * xs2 / xs1 + xs1 * (1. / pow((1. - ps), 2) - xs2);
-    xs4 = (3. * xs1 * xs2 * xs3 - 2. * pow(xs2, 3)) / (xs1 * xs1) + xs1 * (2. / pow((1. - ps), 3) - xs3);
-    xs5 = (-12. * xs1 * xs2 * xs2 * xs3 + 3. * xs1 * xs1 * xs3 * xs3 + 4. * xs1 * xs1 * xs2 * xs4 + 6. * pow(xs2, 4)) /
-          pow(xs1, 3) + xs1 * (6. / pow((1. - ps), 4) - xs4);
-
-    z1 = pr * qr * xr2 / (2. * (n + 2.));
-    z2 = pr * qr * ((qr - pr) * xr3 / 3. + pr * qr * xr4 / 8.) / pow((n + 2.), 2);
-    z3 = -(qr - pr) * xr3 / 3. + (pow((qr - pr), 2) - pr * qr) * xr4 / 4.;
-    z4 = qr * pr * (qr - pr) * xr5 / 6. + qr * qr * pr * pr * xr6 / 48.;
-    er = xr + z1 + z2 + pr * qr * (z3 + z4) / pow((n + 2.), 3);
+    int order = order_expansion();
+    OrderTerms tr = order_terms_weibull(pr, order);
+    OrderTerms ts = order_terms_weibull(ps, order);
 
-    z1 = (qr - pr) * xr2 * xs1 + (qs - ps) * xr1 * xs2 + pr * qr * xr3 * xs1 / 2. +
-         ps * qs * xr1 * xs3 / 2. + pr * qs * xr2 * xs2 / 2.;
-    z1 = z1 * pr * qs / pow((n + 2.), 2);
-    z2 = -(qr - pr) * xr2 * xs1 - (qs - ps) * xr1 * xs2 + (pow((qr - pr), 2) - pr * qr) * xr3 * xs1;
-    z3 = (pow((qs - ps), 2) - ps * qs) * xr1 * xs3 + (1.5 * (qr - pr) * (qs - ps) + 0.5 * ps * qr - 2. * pr * qs) * xr2 * xs2;
-    z4 = (5. / 6.) * pr * qr * (qr - pr) * xr4 * xs1 + (5. / 6.) * ps * qs * (qs - ps) * xr1 * xs4 +
-         (pr * qs * (qr - pr) + .5 * pr * qr * (qs - ps)) * xr3 * xs2;
-    z5 = (pr * qs * (qs - ps) + .5 * ps * qs * (qr - pr)) * xr2 * xs3 + (1. / 8.) * pr * pr * qr * qr * xr5 * xs1 +
-         (1. / 8.) * ps * ps * qs * qs * xr1 * xs5;
-    z6 = 0.25 * pr * pr * qr * qs * xr4 * xs2 + 0.25 * pr * ps * qs * qs * xr2 * xs4 +
-         (2. * pr * pr * qs * qs + 3. * pr * qr * ps * qs) * xr3 * xs3 / 12.;
+    er = order_expectation(n, tr, order);
+    vrs = order_covariance(n, tr, ts, order);
+}
+
+// ============ Векторное ядро ковариаций ============
+// Ковариация - фиксированный полином от производных строки r и столбца s.
+// Полином записан один раз шаблоном: для double это скалярный путь,
+// для векторных типов GCC - AVX2 (4 столбца) и AVX-512 (8 столбцов).
+// Все степени (n+2) и квадраты раскрыты умножениями, pow() во внутреннем цикле нет.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ORDER_SIMD_X86 1
+typedef double order_v4d __attribute__((vector_size(32)));
+typedef double order_v8d __attribute__((vector_size(64)));
+#endif
+
+// Дополнение столбцов до кратного ширине самого широкого вектора
+static const size_t ORDER_COLUMN_PAD = 8;
+
+// Производные столбцов в виде структуры массивов (для векторной загрузки)
+struct OrderColumns {
+    const double *p, *q, *x1, *x2, *x3, *x4, *x5;
+
+    // Число double в буфере storage для m столбцов
+    static size_t storage_size(size_t m) {
+        return 7 * (m + ORDER_COLUMN_PAD);
+    }
+
+    OrderColumns(const OrderTerms* terms, size_t m, double* storage) {
+        size_t padded = m + ORDER_COLUMN_PAD;
+        double* cp = storage;
+        double* cq = cp + padded;
+        double* c1 = cq + padded;
+        double* c2 = c1 + padded;
+        double* c3 = c2 + padded;
+        double* c4 = c3 + padded;
+        double* c5 = c4 + padded;
+        for (size_t j = 0; j < padded; j++) {
+            // хвост заполняется последним столбцом, чтобы лишние дорожки считали конечные значения
+            const OrderTerms& t = terms[std::min(j, m - 1)];
+            cp[j] = t.p; cq[j] = t.q;
+            c1[j] = t.x1; c2[j] = t.x2; c3[j] = t.x3; c4[j] = t.x4; c5[j] = t.x5;
+        }
+        p = cp; q = cq; x1 = c1; x2 = c2; x3 = c3; x4 = c4; x5 = c5;
+    }
+};
+
+// Величины строки r, общие для всех столбцов
+struct OrderRow {
+    double p, q, d, pq;
+    double x1, x2, x3, x4, x5;
+    double c1, c2, c3;      // 1/(n+2), 1/(n+2)^2, 1/(n+2)^3
+
+    OrderRow(int n, const OrderTerms& r)
+        : p(r.p), q(r.q), d(r.q - r.p), pq(r.p * r.q),
+          x1(r.x1), x2(r.x2), x3(r.x3), x4(r.x4), x5(r.x5) {
+        c1 = 1. / (n + 2.);
+        c2 = c1 * c1;
+        c3 = c2 * c1;
+    }
+};
+
+// ORDER - порядок усечения: члены старше (n+2)^{-ORDER} не вычисляются
+template <typename V, int ORDER>
+static inline __attribute__((always_inline))
+void covariance_poly(const OrderRow& r, const V& ps, const V& qs, const V& xs1, const V& xs2,
+                     const V& xs3, const V& xs4, const V& xs5, V& vrs) {
+    V ds = qs - ps;
+    V psqs = ps * qs;
+    V prqs = r.p * qs;
+    V lead = prqs * r.x1 * xs1 * r.c1;
+    V z1, z2, z3, z4, z5, z6, z7;
+
+    if constexpr (ORDER == 1) {
+        vrs = lead;
+        return;
+    }
+
+    z1 = r.d * r.x2 * xs1 + ds * r.x1 * xs2 + 0.5 * r.pq * r.x3 * xs1 +
+         0.5 * psqs * r.x1 * xs3 + 0.5 * prqs * r.x2 * xs2;
+    z1 = z1 * prqs * r.c2;
+
+    if constexpr (ORDER == 2) {
+        vrs = z1 + lead;
+        return;
+    }
+
+    z2 = -r.d * r.x2 * xs1 - ds * r.x1 * xs2 + (r.d * r.d - r.pq) * r.x3 * xs1;
+    z3 = (ds * ds - psqs) * r.x1 * xs3 + (1.5 * r.d * ds + 0.5 * ps * r.q - 2. * prqs) * r.x2 * xs2;
+    z4 = (5. / 6.) * r.pq * r.d * r.x4 * xs1 + (5. / 6.) * psqs * ds * r.x1 * xs4 +
+         (prqs * r.d + 0.5 * r.pq * ds) * r.x3 * xs2;
+    z5 = (prqs * ds + 0.5 * psqs * r.d) * r.x2 * xs3 + 0.125 * r.pq * r.pq * r.x5 * xs1 +
+         0.125 * psqs * psqs * r.x1 * xs5;
+    z6 = 0.25 * r.p * r.pq * qs * r.x4 * xs2 + 0.25 * prqs * psqs * r.x2 * xs4 +
+         (2. * prqs * prqs + 3. * r.pq * psqs) * r.x3 * xs3 * (1. / 12.);
     z7 = z2 + z3 + z4 + z5 + z6;
-    vrs = z1 + pr * qs * z7 / pow((n + 2.), 3) + pr * qs * xr1 * xs1 / (n + 2.);
+
+    vrs = z1 + prqs * z7 * r.c3 + lead;
+}
+
+// Строка ковариаций: out[j] = cov(r, j) для j из [j0, j1)
+typedef void (*CovarianceRowKernel)(const OrderRow& r, const OrderColumns& c,
+                                    size_t j0, size_t j1, double* out);
+
+template <int ORDER>
+static void covariance_row_scalar(const OrderRow& r, const OrderColumns& c,
+                                  size_t j0, size_t j1, double* out) {
+    for (size_t j = j0; j < j1; j++) {
+        covariance_poly<double, ORDER>(r, c.p[j], c.q[j], c.x1[j], c.x2[j], c.x3[j], c.x4[j], c.x5[j], out[j]);
+    }
+}
+
+#ifdef ORDER_SIMD_X86
+// Векторные ядра: неполный последний блок тоже считается целым вектором
+// (столбцы дополнены), поэтому значение элемента не зависит от его позиции в строке
+#define ORDER_COVARIANCE_ROW_SIMD(NAME, TARGET, VTYPE, WIDTH)                                     \
+    template <int ORDER>                                                                         \
+    __attribute__((target(TARGET)))                                                              \
+    static void NAME(const OrderRow& r, const OrderColumns& c, size_t j0, size_t j1, double* out) { \
+        VTYPE ps, qs, xs1, xs2, xs3, xs4, xs5, vrs;                                              \
+        for (size_t j = j0; j < j1; j += WIDTH) {                                                \
+            std::memcpy(&ps, &c.p[j], sizeof(VTYPE));                                            \
+            std::memcpy(&qs, &c.q[j], sizeof(VTYPE));                                            \
+            std::memcpy(&xs1, &c.x1[j], sizeof(VTYPE));                                          \
+            std::memcpy(&xs2, &c.x2[j], sizeof(VTYPE));                                          \
+            std::memcpy(&xs3, &c.x3[j], sizeof(VTYPE));                                          \
+            std::memcpy(&xs4, &c.x4[j], sizeof(VTYPE));                                          \
+            std::memcpy(&xs5, &c.x5[j], sizeof(VTYPE));                                          \
+            covariance_poly<VTYPE, ORDER>(r, ps, qs, xs1, xs2, xs3, xs4, xs5, vrs);              \
+            size_t count = std::min<size_t>(WIDTH, j1 - j);                                      \
+            std::memcpy(&out[j], &vrs, count * sizeof(double));                                  \
+        }                                                                                        \
+    }
+
+ORDER_COVARIANCE_ROW_SIMD(covariance_row_avx2, "avx2,fma", order_v4d, 4)
+ORDER_COVARIANCE_ROW_SIMD(covariance_row_avx512, "avx512f", order_v8d, 8)
+#undef ORDER_COVARIANCE_ROW_SIMD
+#endif
+
+static OrderKernel order_kernel_requested = ORDER_KERNEL_AUTO;
+
+void order_set_kernel(OrderKernel kernel) {
+    order_kernel_requested = kernel;
+}
+
+OrderKernel order_active_kernel() {
+#ifdef ORDER_SIMD_X86
+    bool has_avx512 = __builtin_cpu_supports("avx512f");
+    bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+
+    switch (order_kernel_requested) {
+        case ORDER_KERNEL_SCALAR:
+            return ORDER_KERNEL_SCALAR;
+        case ORDER_KERNEL_AVX512:
+            if (has_avx512) return ORDER_KERNEL_AVX512;
+            break;
+        case ORDER_KERNEL_AVX2:
+            if (has_avx2) return ORDER_KERNEL_AVX2;
+            return ORDER_KERNEL_SCALAR;
+        case ORDER_KERNEL_AUTO:
+            break;
+    }
+    if (has_avx512) return ORDER_KERNEL_AVX512;
+    if (has_avx2) return ORDER_KERNEL_AVX2;
+#endif
+    return ORDER_KERNEL_SCALAR;
+}
+
+// Экземпляры ядер по порядку усечения (индекс order - 1)
+#define ORDER_KERNEL_TABLE(NAME) { NAME<1>, NAME<2>, NAME<3> }
+static const CovarianceRowKernel covariance_row_scalar_table[ORDER_EXPANSION_MAX] =
+    ORDER_KERNEL_TABLE(covariance_row_scalar);
+#ifdef ORDER_SIMD_X86
+static const CovarianceRowKernel covariance_row_avx2_table[ORDER_EXPANSION_MAX] =
+    ORDER_KERNEL_TABLE(covariance_row_avx2);
+static const CovarianceRowKernel covariance_row_avx512_table[ORDER_EXPANSION_MAX] =
+    ORDER_KERNEL_TABLE(covariance_row_avx512);
+#endif
+#undef ORDER_KERNEL_TABLE
+
+static CovarianceRowKernel covariance_row_kernel(int order) {
+    switch (order_active_kernel()) {
+#ifdef ORDER_SIMD_X86
+        case ORDER_KERNEL_AVX512: return covariance_row_avx512_table[order - 1];
+        case ORDER_KERNEL_AVX2:   return covariance_row_avx2_table[order - 1];
+#endif
+        default:                  return covariance_row_scalar_table[order - 1];
+    }
+}
+
+// ============ Пакетное вычисление для всей выборки ============
+// Производные кешируются по индексам, затем верхний треугольник ковариационной
+// матрицы разбивается на квадратные блоки, которые раздаются потокам пула.
+// Каждый блок пишется сразу на место, вместе со своим отражением под диагональю.
+// Значение элемента зависит только от ядра, но не от блока и потока,
+// поэтому результат побитово одинаков при любом числе потоков.
+
+static const size_t ORDER_TILE = 128;   // 128 x 128 double = 128 КБ (L2)
+
+static void order_expectations(int n, int order, const OrderTerms* terms, size_t m, double* er,
+                               double* error_bound) {
+    if (error_bound != nullptr) *error_bound = 0.0;
+
+    for (size_t i = 0; i < m; i++) {
+        er[i] = order_expectation(n, terms[i], order);
+        if (error_bound != nullptr) {
+            *error_bound = std::max(*error_bound, order_truncation_error(n, terms[i], order));
+        }
+    }
+}
+
+// Заполнение верхнего треугольника блоками: row_at(i)[j] - элемент (i, j),
+// mirror(i, j0, j1, row) - отражение строки под диагональ (для плотной матрицы).
+// Столбцы производных размещаются в рабочей области ws.
+template <typename RowAt, typename Mirror>
+static void order_fill_upper(int n, int order, const OrderTerms* terms, size_t m, GlsWorkspace& ws,
+                             RowAt row_at, Mirror mirror) {
+    GlsWorkspace::Scope scope(ws);
+    OrderColumns columns(terms, m, ws.take(OrderColumns::storage_size(m)));
+    CovarianceRowKernel kernel = covariance_row_kernel(order);
+
+    // Блоки верхнего треугольника (bi <= bj) нумеруются в порядке строк
+    size_t nb = (m + ORDER_TILE - 1) / ORDER_TILE;
+    auto tile = [&](size_t t) {
+        size_t bi = 0;
+        while (t >= nb - bi) {
+            t -= nb - bi;
+            bi++;
+        }
+        size_t i0 = bi * ORDER_TILE, i1 = std::min(i0 + ORDER_TILE, m);
+        size_t j0 = (bi + t) * ORDER_TILE, j1 = std::min(j0 + ORDER_TILE, m);
+
+        for (size_t i = i0; i < i1; i++) {
+            size_t js = std::max(j0, i);
+            double* row = row_at(i);
+            kernel(OrderRow(n, terms[i]), columns, js, j1, row);
+            mirror(i, std::max(js, i + 1), j1, row);
+        }
+    };
+    // Тело передается по ссылке: std::function хранит ее без выделения памяти
+    global_thread_pool().parallel_for(nb * (nb + 1) / 2, [&tile](size_t t) { tile(t); });
+}
+
+static void order_terms(OrderFamily family, int order, const double* probs, size_t m, OrderTerms* terms) {
+    for (size_t i = 0; i < m; i++) {
+        terms[i] = (family == ORDER_NORMAL) ? order_terms_normal(probs[i], order)
+                                            : order_terms_weibull(probs[i], order);
+    }
+}
+
+static void order_matrix(OrderFamily family, int n, const std::vector<double>& probs, Vector& er, Matrix& v,
+                         double* error_bound) {
+    int order = order_expansion();
+    size_t m = probs.size();
+    er.resize(m, false);
+    v.resize(m, m, false);
+    if (m == 0) {
+        if (error_bound != nullptr) *error_bound = 0.0;
+        return;
+    }
+
+    GlsWorkspace ws;
+    OrderTerms* terms = ws.take_as<OrderTerms>(m);
+    order_terms(family, order, probs.data(), m, terms);
+    order_expectations(n, order, terms, m, &er(0), error_bound);
+
+    double* data = &v(0, 0);
+    order_fill_upper(n, order, terms, m, ws,
+                     [&](size_t i) { return data + i * m; },
+                     [&](size_t i, size_t j0, size_t j1, const double* row) {
+                         for (size_t j = j0; j < j1; j++) {
+                             data[j * m + i] = row[j];
+                         }
+                     });
+}
+
+// Упакованная матрица: каждый элемент вычисляется и записывается один раз
+static void order_matrix_packed(OrderFamily family, int n, const double* probs, size_t m, GlsWorkspace& ws,
+                                double* er, double* v, double* error_bound) {
+    GlsWorkspace::Scope scope(ws);
+    int order = order_expansion();
+    OrderTerms* terms = ws.take_as<OrderTerms>(m);
+    order_terms(family, order, probs, m, terms);
+    order_expectations(n, order, terms, m, er, error_bound);
+
+    order_fill_upper(n, order, terms, m, ws,
+                     [&](size_t i) { return v + packed_row_offset(m, i) - i; },
+                     [](size_t, size_t, size_t, const double*) {});
+}
+
+static void order_matrix(OrderFamily family, int n, const std::vector<double>& probs, Vector& er,
+                         SymmetricMatrix& v, double* error_bound) {
+    size_t m = probs.size();
+    er.resize(m, false);
+    v.resize(m, false);
+    if (m == 0) {
+        if (error_bound != nullptr) *error_bound = 0.0;
+        return;
+    }
+
+    GlsWorkspace ws;
+    order_matrix_packed(family, n, probs.data(), m, ws, &er(0), &v.data()[0], error_bound);
+}
+
+// Блоки строк полной матрицы без хранения m x m. Элемент (i, j) при j >= i
+// берется из строки i, при j < i - из строки j (как отражение в order_matrix),
+// поэтому значения совпадают с плотной матрицей побитово. Нижняя часть
+// блока слева от диагонали считается по строкам j < i0 в буфер lower (по столбцам блока).
+void order_matrix_tiled(OrderFamily family, int n, const std::vector<double>& probs, size_t rows_per_tile,
+                        Vector& er, const std::function<void(size_t, size_t, const double*)>& sink) {
+    int order = order_expansion();
+    size_t m = probs.size();
+    er.resize(m, false);
+    if (m == 0) return;
+    size_t tile = std::max<size_t>(1, std::min(rows_per_tile, m));
+
+    GlsWorkspace ws;
+    OrderTerms* terms = ws.take_as<OrderTerms>(m);
+    order_terms(family, order, probs.data(), m, terms);
+    order_expectations(n, order, terms, m, &er(0), nullptr);
+
+    OrderColumns columns(terms, m, ws.take(OrderColumns::storage_size(m)));
+    CovarianceRowKernel kernel = covariance_row_kernel(order);
+    double* rows = ws.take(tile * m);
+    double* lower = ws.take(m * tile);
+    ThreadPool& pool = global_thread_pool();
+
+    for (size_t i0 = 0; i0 < m; i0 += tile) {
+        size_t i1 = std::min(i0 + tile, m);
+        size_t h = i1 - i0;
+
+        // Верхний треугольник строк блока, начиная с диагонали
+        pool.parallel_for(h, [&](size_t t) {
+            size_t i = i0 + t;
+            kernel(OrderRow(n, terms[i]), columns, i, m, rows + t * m);
+        });
+
+        // Столбцы блока в строках выше него: lower[j * h + (i - i0)] = V(j, i)
+        size_t groups = (i0 + ORDER_TILE - 1) / ORDER_TILE;
+        pool.parallel_for(groups, [&](size_t g) {
+            size_t j1 = std::min((g + 1) * ORDER_TILE, i0);
+            for (size_t j = g * ORDER_TILE; j < j1; j++) {
+                kernel(OrderRow(n, terms[j]), columns, i0, i1, lower + j * h - i0);
+            }
+        });
+
+        for (size_t t = 0; t < h; t++) {
+            double* row = rows + t * m;
+            for (size_t j = 0; j < i0; j++) row[j] = lower[j * h + t];
+            for (size_t j = i0; j < i0 + t; j++) row[j] = rows[(j - i0) * m + i0 + t];
+        }
+        sink(i0, i1, rows);
+    }
+}
+
+void ordern_matrix(int n, const std::vector<double>& probs, Vector& er, Matrix& v, double* error_bound) {
+    order_matrix(ORDER_NORMAL, n, probs, er, v, error_bound);
+}
+
+void orderw_matrix(int n, const std::vector<double>& probs, Vector& er, Matrix& v, double* error_bound) {
+    order_matrix(ORDER_WEIBULL, n, probs, er, v, error_bound);
+}
+
+void ordern_matrix(int n, const std::vector<double>& probs, Vector& er, SymmetricMatrix& v,
+                   double* error_bound) {
+    order_matrix(ORDER_NORMAL, n, probs, er, v, error_bound);
+}
+
+void orderw_matrix(int n, const std::vector<double>& probs, Vector& er, SymmetricMatrix& v,
+                   double* error_bound) {
+    order_matrix(ORDER_WEIBULL, n, probs, er, v, error_bound);
 }
 
 // ============ Вспомогательные функции для MLS ============
 
-// Вычисление эмпирической функции распределения для полных данных
-void cum(int n, const std::vector<double>& x, const std::vector<int>& r, int km,
-         std::vector<double>& fcum, std::vector<double>& ycum) {
-    std::vector<double> sorted_data;
+// Вычисление эмпирической функции распределения
+// Для цензурированной выборки (правая цензура II типа или прогрессивная)
+// вероятности отказов берутся по скорректированным рангам Джонсона:
+//   rank_k = rank_{k-1} + (n + 1 - rank_{k-1}) / (1 + число объектов начиная с текущего),
+// т.е. порядковые статистики остаются статистиками выборки объема n.
+// Для полной выборки это (i+1)/(n+1).
+void cum(int n, const double* x, const int* r, int km, double* fcum, double* ycum, GlsWorkspace& ws) {
+    GlsWorkspace::Scope scope(ws);
+    struct Observation {
+        double x;
+        int r;
+    };
+    Observation* sorted_data = ws.take_as<Observation>(n);
     for (int i = 0; i < n; i++) {
-        if (r[i] == 0) {  // только полные наблюдения
-            sorted_data.push_back(x[i]);
-        }
+        sorted_data[i] = {x[i], r != nullptr ? r[i] : 0};
     }
-    std::sort(sorted_data.begin(), sorted_data.end());
+    // при равенстве отказ раньше цензуры
+    std::sort(sorted_data, sorted_data + n, [](const Observation& a, const Observation& b) {
+        return a.x < b.x || (a.x == b.x && a.r < b.r);
+    });
 
-    for (int i = 0; i < km; i++) {
-        ycum[i] = sorted_data[i];
-        fcum[i] = (i + 1.0) / (km + 1.0);  // эмпирическая вероятность
+    double rank = 0.0;
+    int k = 0;
+    for (int i = 0; i < n && k < km; i++) {
+        if (sorted_data[i].r == 0) {  // только полные наблюдения
+            rank += (n + 1.0 - rank) / (n - i + 1.0);
+            ycum[k] = sorted_data[i].x;
+            fcum[k] = rank / (n + 1.0);  // эмпирическая вероятность
+            k++;
+        }
     }
 }
 
+void cum(int n, const std::vector<double>& x, const std::vector<int>& r, int km,
+         std::vector<double>& fcum, std::vector<double>& ycum) {
+    GlsWorkspace ws;
+    cum(n, x.data(), r.data(), km, fcum.data(), ycum.data(), ws);
+}
+
 // Вычисление начальных оценок параметров
 void standart(int km, const std::vector<double>& ycum, double& cp, double& cko) {
+    standart(km, ycum.data(), cp, cko);
+}
+
+void standart(int km, const double* ycum, double& cp, double& cko) {
     // Простая оценка через выборочные моменты
     cp = 0.0;  // среднее
     for (int i = 0; i < km; i++) {
@@ -154,43 +645,204 @@ void standart(int km, const std::vector<double>& ycum, double& cp, double& cko)
     cko = std::sqrt(cko / (km - 1));
 }
 
+// ============ Точность плотного взвешенного МНК ============
+
+static GlsPrecision gls_precision_requested = GLS_PRECISION_DOUBLE;
+
+void gls_set_precision(GlsPrecision precision) {
+    gls_precision_requested = precision;
+}
+
+GlsPrecision gls_precision() {
+    return gls_precision_requested;
+}
+
+// Нормальные уравнения малого размера k x k (упакованы в рабочей области):
+// A = U^T Wx, c = U^T Wy. После "отбеливания" U = Wx = L^{-1} X, Wy = L^{-1} y;
+// при решении V Z = [X | y] U = X, Wx = Zx, Wy = Zy.
+// Все матрицы по строкам: x, u, wx - n x k, wy - n x ny, db - k x k, b - k x ny, yr - n
+static void gls_normal(const double* x, const double* u, const double* wx, const double* wy,
+                       size_t n, size_t k, size_t ny,
+                       GlsWorkspace& ws, double* db, double* b, double* yr) {
+    GlsWorkspace::Scope scope(ws);
+
+    // A (верхний треугольник), b = c
+    double* a = ws.take(k * (k + 1) / 2);
+    for (size_t r = 0; r < k; r++) {
+        double* ar = a + packed_row_offset(k, r) - r;
+        for (size_t q = r; q < k; q++) {
+            double sum = 0.0;
+            for (size_t i = 0; i < n; i++) sum += u[i * k + r] * wx[i * k + q];
+            ar[q] = sum;
+        }
+        for (size_t q = 0; q < ny; q++) {
+            double sum = 0.0;
+            for (size_t i = 0; i < n; i++) sum += u[i * k + r] * wy[i * ny + q];
+            b[r * ny + q] = sum;
+        }
+    }
+
+    // db = A^{-1} - ковариационная матрица параметров (k x k), b = A^{-1} c
+    CholeskyDecomposePacked(a, k);
+    for (size_t r = 0; r < k; r++) {
+        for (size_t q = 0; q < k; q++) {
+            db[r * k + q] = (r == q) ? 1.0 : 0.0;
+        }
+    }
+    SolveLowerPacked(a, k, db, k);
+    SolveLowerTransPacked(a, k, db, k);
+    SolveLowerPacked(a, k, b, ny);
+    SolveLowerTransPacked(a, k, b, ny);
+
+    // Предсказанные значения: yr = X * b
+    for (size_t i = 0; i < n; i++) {
+        yr[i] = 0.0;
+        for (size_t j = 0; j < k; j++) {
+            yr[i] += x[i * k + j] * b[j * ny];
+        }
+    }
+}
+
+// Взвешенный МНК с упакованной V в буфере l (n(n+1)/2, на выходе - множитель Холецкого)
+static void gls_packed(const double* x, const double* y, double* l, size_t n, size_t k, size_t ny,
+                       GlsWorkspace& ws, double* db, double* b, double* yr) {
+    GlsWorkspace::Scope scope(ws);
+
+    // V = L L^T
+    CholeskyDecomposePacked(l, n);
+
+    // Xw = L^{-1} X, yw = L^{-1} y
+    double* xw = ws.take(n * k);
+    double* yw = ws.take(n * ny);
+    std::copy(x, x + n * k, xw);
+    std::copy(y, y + n * ny, yw);
+    SolveLowerPacked(l, n, xw, k);
+    SolveLowerPacked(l, n, yw, ny);
+
+    gls_normal(x, xw, xw, yw, n, k, ny, ws, db, b, yr);
+}
+
+// Размеры выходов взвешенного МНК (без сохранения содержимого: при совпадении размера память не выделяется)
+static void gls_resize_outputs(size_t n, size_t k, size_t ny, Matrix& db, Matrix& b, Vector& yr) {
+    db.resize(k, k, false);
+    b.resize(k, ny, false);
+    yr.resize(n, false);
+}
+
 /**
- * Взвешенный МНК (обобщенный метод наименьших квадратов) через Boost.uBLAS
+ * Взвешенный МНК (обобщенный метод наименьших квадратов) через разложение Холецкого
  * Формула: b = (X^T V^{-1} X)^{-1} X^T V^{-1} y
- * где V - ковариационная матрица ошибок
+ * где V - ковариационная матрица ошибок.
+ * V = L L^T раскладывается один раз; после "отбеливания" Xw = L^{-1} X,
+ * yw = L^{-1} y задача сводится к обычному МНК: X^T V^{-1} X = Xw^T Xw.
+ * V^{-1} и X^T не формируются, из матриц n x n в памяти только L.
+ * В смешанной точности решается V Z = [X | y] (CholeskySolveMixed),
+ * тогда X^T V^{-1} X = X^T Zx, X^T V^{-1} y = X^T Zy.
  */
 void MleastSquare_weight(const Matrix& x, const Matrix& y, const Matrix& v,
-                         Matrix& db, Matrix& b, Vector& yr) {
-    // V^{-1}
-    Matrix v_inv = InverseMatrix(v);
+                         Matrix& db, Matrix& b, Vector& yr, RefinementReport* refinement) {
+    size_t n = x.size1();
+    size_t k = x.size2();
+    size_t ny = y.size2();
+    if (v.size1() != n || y.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для взвешенного МНК");
+    }
 
-    // X^T
-    Matrix x_t = TransMatrix(x);
+    if (gls_precision_requested == GLS_PRECISION_MIXED) {
+        Matrix z(n, k + ny);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < k; j++) z(i, j) = x(i, j);
+            for (size_t j = 0; j < ny; j++) z(i, k + j) = y(i, j);
+        }
+        CholeskySolveMixed(v, z, refinement);
 
-    // X^T V^{-1}
-    Matrix xt_v_inv = MultiplyMatrix(x_t, v_inv);
+        Matrix zx(n, k), zy(n, ny);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < k; j++) zx(i, j) = z(i, j);
+            for (size_t j = 0; j < ny; j++) zy(i, j) = z(i, k + j);
+        }
 
-    // X^T V^{-1} X
-    Matrix xt_v_inv_x = MultiplyMatrix(xt_v_inv, x);
+        gls_resize_outputs(n, k, ny, db, b, yr);
+        GlsWorkspace ws;
+        gls_normal(x.data().begin(), x.data().begin(), zx.data().begin(), zy.data().begin(),
+                   n, k, ny, ws, db.data().begin(), b.data().begin(), yr.data().begin());
+        return;
+    }
+    if (refinement != nullptr) *refinement = RefinementReport();
 
-    // (X^T V^{-1} X)^{-1} - ковариационная матрица параметров
-    db = InverseMatrix(xt_v_inv_x);
+    // V = L L^T
+    Matrix l(v);
+    CholeskyDecompose(l);
 
-    // X^T V^{-1} y
-    Matrix xt_v_inv_y = MultiplyMatrix(xt_v_inv, y);
+    // Xw = L^{-1} X, yw = L^{-1} y
+    Matrix xw(x);
+    Matrix yw(y);
+    SolveLower(l, xw);
+    SolveLower(l, yw);
 
-    // b = (X^T V^{-1} X)^{-1} X^T V^{-1} y
-    b = MultiplyMatrix(db, xt_v_inv_y);
+    gls_resize_outputs(n, k, ny, db, b, yr);
+    GlsWorkspace ws;
+    gls_normal(x.data().begin(), xw.data().begin(), xw.data().begin(), yw.data().begin(), n, k, ny, ws,
+               db.data().begin(), b.data().begin(), yr.data().begin());
+}
 
-    // Предсказанные значения: yr = X * b
+/**
+ * То же для упакованной симметричной V: множитель Холецкого тоже упакован,
+ * в памяти n(n+1)/2 элементов вместо n²
+ */
+void MleastSquare_weight(const Matrix& x, const Matrix& y, const SymmetricMatrix& v,
+                         Matrix& db, Matrix& b, Vector& yr) {
+    GlsWorkspace ws;
+    MleastSquare_weight(x, y, v, db, b, yr, ws);
+}
+
+void MleastSquare_weight(const Matrix& x, const Matrix& y, const SymmetricMatrix& v,
+                         Matrix& db, Matrix& b, Vector& yr, GlsWorkspace& ws) {
     size_t n = x.size1();
     size_t k = x.size2();
-    yr.resize(n);
+    size_t ny = y.size2();
+    if (v.size1() != n || y.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для взвешенного МНК");
+    }
 
-    for (size_t i = 0; i < n; i++) {
-        yr(i) = 0.0;
-        for (size_t j = 0; j < k; j++) {
-            yr(i) += x(i, j) * b(j, 0);
-        }
+    GlsWorkspace::Scope scope(ws);
+    double* l = ws.take(v.data().size());
+    std::copy(v.data().begin(), v.data().end(), l);
+
+    gls_resize_outputs(n, k, ny, db, b, yr);
+    gls_packed(x.data().begin(), y.data().begin(), l, n, k, ny, ws,
+               db.data().begin(), b.data().begin(), yr.data().begin());
+}
+
+/**
+ * Регрессия ycum = b0 + b1 * E по моментам порядковых статистик: V (упакованная),
+ * X и y строятся прямо в рабочей области, V раскладывается на месте
+ */
+void MleastSquare_order(OrderFamily family, int n, const double* fcum, const double* ycum, size_t m,
+                        GlsWorkspace& ws, double* b, double* db) {
+    GlsWorkspace::Scope scope(ws);
+    double* er = ws.take(m);
+    double* v = ws.take(m * (m + 1) / 2);
+    order_matrix_packed(family, n, fcum, m, ws, er, v, nullptr);
+
+    // Столбцы сдвига и масштаба (математические ожидания порядковых статистик)
+    double* x = ws.take(2 * m);
+    for (size_t i = 0; i < m; i++) {
+        x[2 * i] = 1.0;
+        x[2 * i + 1] = er[i];
     }
+    double* yr = ws.take(m);
+
+    gls_packed(x, ycum, v, m, 2, 1, ws, db, b, yr);
+}
+
+size_t mls_workspace_size(size_t m) {
+    // Верхняя оценка: сумма всех буферов MLS по m порядковым статистикам -
+    // логарифмы данных, fcum, ycum, er, yr (по m), V, X, упорядоченная выборка,
+    // производные и их столбцы, отбеленные X и y, нормальные уравнения 2 x 2
+    size_t terms = (m * sizeof(OrderTerms) + sizeof(double) - 1) / sizeof(double);
+    return 5 * GlsWorkspace::slice(m) + GlsWorkspace::slice(m * (m + 1) / 2) +
+           3 * GlsWorkspace::slice(2 * m) + GlsWorkspace::slice(terms) +
+           GlsWorkspace::slice(OrderColumns::storage_size(m)) + GlsWorkspace::slice(m) +
+           GlsWorkspace::slice(3);
 }
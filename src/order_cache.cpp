@@ -0,0 +1,351 @@
+#include "order_cache.h"
+#include "order.h"
+#include "matrix_operations.h"
+#include "small_matrix.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Кеш таблиц порядковых статистик: файл на (семейство, n, порядок разложения) вида
+//   [заголовок 64 байта][er: n][v: n*n][w: 2*n][db: 4]
+// При следующем запуске файл отображается в память без пересчета
+
+static const char ORDER_TABLE_MAGIC[8] = {'A', 'G', 'O', 'R', 'D', 'T', 'B', '\0'};
+static const uint32_t ORDER_TABLE_VERSION = 2;
+
+struct OrderTableHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t family;
+    uint64_t n;
+    uint64_t count;     // число double после заголовка
+    uint32_t order;     // порядок разложения Дэйвида-Джонсона
+    char reserved[28];
+};
+static_assert(sizeof(OrderTableHeader) == 64, "заголовок должен сохранять выравнивание данных");
+
+// Запись кеша: либо отображенный файл, либо собственный буфер
+struct OrderCacheEntry {
+    OrderTable table;
+    std::vector<double> storage;
+    void* mapped = nullptr;
+    size_t mapped_size = 0;
+
+    ~OrderCacheEntry() {
+#ifndef _WIN32
+        if (mapped != nullptr) {
+            munmap(mapped, mapped_size);
+        }
+#endif
+    }
+};
+
+static std::mutex cache_mutex;
+static std::map<std::tuple<int, int, int>, std::unique_ptr<OrderCacheEntry>> cache_entries;
+static bool cache_dir_initialized = false;
+static std::string cache_dir;
+
+static uint64_t table_count(int n) {
+    return uint64_t(n) + uint64_t(n) * n + 2 * uint64_t(n) + 4;
+}
+
+static std::string table_path(OrderFamily family, int n, int order) {
+    const char* name = (family == ORDER_NORMAL) ? "normal" : "weibull";
+    return cache_dir + "/order_" + name + "_" + std::to_string(n) + "_" + std::to_string(order) + ".bin";
+}
+
+// Расстановка указателей таблицы по непрерывному блоку данных
+static void bind_table(OrderTable& table, OrderFamily family, int n, int order, const double* data) {
+    table.family = family;
+    table.n = n;
+    table.order = order;
+    table.er = data;
+    table.v = table.er + n;
+    table.w = table.v + size_t(n) * n;
+    table.db = table.w + 2 * size_t(n);
+}
+
+static bool header_valid(const OrderTableHeader& h, OrderFamily family, int n, int order) {
+    return std::memcmp(h.magic, ORDER_TABLE_MAGIC, sizeof(h.magic)) == 0 &&
+           h.version == ORDER_TABLE_VERSION && h.family == uint32_t(family) &&
+           h.n == uint64_t(n) && h.count == table_count(n) && h.order == uint32_t(order);
+}
+
+// Построение таблицы: ordern_matrix/orderw_matrix + веса взвешенного МНК
+static void build_table(OrderFamily family, int n, std::vector<double>& data) {
+    std::vector<double> probs(n);
+    for (int i = 0; i < n; i++) {
+        probs[i] = (i + 1.0) / (n + 1.0);
+    }
+
+    Vector er;
+    Matrix v;
+    if (family == ORDER_NORMAL) {
+        ordern_matrix(n, probs, er, v);
+    } else {
+        orderw_matrix(n, probs, er, v);
+    }
+
+    Matrix x = createMatrix(n, 2);
+    for (int i = 0; i < n; i++) {
+        x(i, 0) = 1.0;
+        x(i, 1) = er(i);
+    }
+
+    // W = (X^T V^{-1} X)^{-1} X^T V^{-1} = db (V^{-1} X)^T, где V^{-1} X = L^{-T} L^{-1} X
+    // находится двумя треугольными решениями с множителем Холецкого V = L L^T
+    Matrix l(v);
+    CholeskyDecompose(l);
+    Matrix v_inv_x(x);
+    SolveLower(l, v_inv_x);
+    SolveLowerTrans(l, v_inv_x);
+
+    Mat2 a;
+    for (int r = 0; r < 2; r++)
+        for (int c = 0; c < 2; c++)
+            for (int i = 0; i < n; i++) a(r, c) += x(i, r) * v_inv_x(i, c);
+    Mat2 db = inverse(a);
+
+    Matrix w = createMatrix(2, n);
+    for (int r = 0; r < 2; r++)
+        for (int i = 0; i < n; i++)
+            w(r, i) = db(r, 0) * v_inv_x(i, 0) + db(r, 1) * v_inv_x(i, 1);
+
+    data.resize(table_count(n));
+    double* p = data.data();
+    for (int i = 0; i < n; i++) *p++ = er(i);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++) *p++ = v(i, j);
+    for (int k = 0; k < 2; k++)
+        for (int j = 0; j < n; j++) *p++ = w(k, j);
+    for (int k = 0; k < 2; k++)
+        for (int j = 0; j < 2; j++) *p++ = db(k, j);
+}
+
+// Загрузка таблицы из файла прошлого запуска
+static bool load_table(const std::string& path, OrderFamily family, int n, int order, OrderCacheEntry& entry) {
+    size_t expected = sizeof(OrderTableHeader) + table_count(n) * sizeof(double);
+
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) != expected) {
+        close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    const OrderTableHeader* h = static_cast<const OrderTableHeader*>(mapped);
+    if (!header_valid(*h, family, n, order)) {
+        munmap(mapped, expected);
+        return false;
+    }
+
+    entry.mapped = mapped;
+    entry.mapped_size = expected;
+    bind_table(entry.table, family, n, order,
+               reinterpret_cast<const double*>(static_cast<const char*>(mapped) + sizeof(OrderTableHeader)));
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    OrderTableHeader h;
+    if (!file.read(reinterpret_cast<char*>(&h), sizeof(h)) || !header_valid(h, family, n, order)) {
+        return false;
+    }
+    entry.storage.resize(table_count(n));
+    if (!file.read(reinterpret_cast<char*>(entry.storage.data()), entry.storage.size() * sizeof(double))) {
+        return false;
+    }
+    bind_table(entry.table, family, n, order, entry.storage.data());
+    return expected == sizeof(h) + entry.storage.size() * sizeof(double);
+#endif
+}
+
+// Запись таблицы: во временный файл и атомарное переименование,
+// чтобы параллельный запуск не увидел недописанный файл.
+// write_data пишет table_count(n) double после заголовка
+static bool save_table(const std::string& path, OrderFamily family, int n, int order,
+                       const std::function<void(std::ostream&)>& write_data) {
+    OrderTableHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, ORDER_TABLE_MAGIC, sizeof(h.magic));
+    h.version = ORDER_TABLE_VERSION;
+    h.family = family;
+    h.n = n;
+    h.count = table_count(n);
+    h.order = order;
+
+    std::error_code ec;
+    std::filesystem::create_directories(cache_dir, ec);
+
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Предупреждение: не удалось записать кеш " << tmp << "\n";
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        write_data(file);
+        if (!file) {
+            std::cerr << "Предупреждение: ошибка записи кеша " << tmp << "\n";
+            file.close();
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::cerr << "Предупреждение: не удалось сохранить кеш " << path << "\n";
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+static void write_doubles(std::ostream& out, const double* p, size_t count) {
+    out.write(reinterpret_cast<const char*>(p), count * sizeof(double));
+}
+
+// Строк V в блоке при построении таблицы по частям
+static const size_t ORDER_TABLE_TILE_ROWS = 128;
+
+// Построение таблицы по частям прямо в файл: V - блоками строк (order_matrix_tiled),
+// веса W = db (V^{-1} X)^T - по структурированной ковариации без матрицы n x n
+static bool save_table_tiled(const std::string& path, OrderFamily family, int n, int order) {
+    std::vector<double> probs(n);
+    for (int i = 0; i < n; i++) {
+        probs[i] = (i + 1.0) / (n + 1.0);
+    }
+
+    Vector er;
+    OrderCovariance cov;
+    order_covariance_structured(family, n, probs, er, cov);
+
+    // V^{-1} X по столбцам X = [1, E]
+    std::vector<double> column(n), v_inv_1, v_inv_e;
+    std::fill(column.begin(), column.end(), 1.0);
+    order_covariance_solve(cov, column, v_inv_1);
+    for (int i = 0; i < n; i++) column[i] = er(i);
+    order_covariance_solve(cov, column, v_inv_e);
+
+    Mat2 a;
+    for (int i = 0; i < n; i++) {
+        a(0, 0) += v_inv_1[i];
+        a(0, 1) += v_inv_e[i];
+        a(1, 0) += er(i) * v_inv_1[i];
+        a(1, 1) += er(i) * v_inv_e[i];
+    }
+    Mat2 db = inverse(a);
+
+    std::vector<double> w(2 * size_t(n));
+    for (int r = 0; r < 2; r++)
+        for (int i = 0; i < n; i++)
+            w[r * n + i] = db(r, 0) * v_inv_1[i] + db(r, 1) * v_inv_e[i];
+
+    return save_table(path, family, n, order, [&](std::ostream& out) {
+        write_doubles(out, &er(0), n);
+        Vector er_rows;
+        order_matrix_tiled(family, n, probs, ORDER_TABLE_TILE_ROWS, er_rows,
+                           [&](size_t i0, size_t i1, const double* rows) {
+                               write_doubles(out, rows, (i1 - i0) * size_t(n));
+                           });
+        write_doubles(out, w.data(), w.size());
+        write_doubles(out, db.data(), 4);
+    });
+}
+
+static void init_cache_dir() {
+    if (!cache_dir_initialized) {
+        const char* env = std::getenv("AGAMIROV_ORDER_CACHE");
+        cache_dir = (env != nullptr) ? env : "";
+        cache_dir_initialized = true;
+    }
+}
+
+void order_cache_set_dir(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_dir = dir;
+    cache_dir_initialized = true;
+}
+
+bool order_cache_enabled() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    init_cache_dir();
+    return !cache_dir.empty();
+}
+
+const OrderTable* order_table(OrderFamily family, int n, OrderTableBuild build) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    init_cache_dir();
+    if (cache_dir.empty() || n < 2) return nullptr;
+
+    int order = order_expansion();
+    auto key = std::make_tuple(int(family), n, order);
+    auto it = cache_entries.find(key);
+    if (it != cache_entries.end()) {
+        return &it->second->table;
+    }
+
+    std::unique_ptr<OrderCacheEntry> entry(new OrderCacheEntry());
+    std::string path = table_path(family, n, order);
+    if (!load_table(path, family, n, order, *entry)) {
+        if (build == ORDER_TABLE_NONE) return nullptr;
+        if (build == ORDER_TABLE_TILED) {
+            entry.reset(new OrderCacheEntry());
+            if (!save_table_tiled(path, family, n, order) || !load_table(path, family, n, order, *entry)) {
+                return nullptr;
+            }
+        } else {
+            build_table(family, n, entry->storage);
+            const std::vector<double>& data = entry->storage;
+            save_table(path, family, n, order,
+                       [&](std::ostream& out) { write_doubles(out, data.data(), data.size()); });
+            bind_table(entry->table, family, n, order, entry->storage.data());
+        }
+    }
+
+    const OrderTable* table = &entry->table;
+    cache_entries[key] = std::move(entry);
+    return table;
+}
+
+size_t order_table_memory(int n, OrderTableBuild build) {
+    size_t m = n > 0 ? size_t(n) : 0;
+    switch (build) {
+        case ORDER_TABLE_DENSE:
+            // V, ее множитель L и таблица (n² каждая) плюс вероятности, X, V^{-1} X,
+            // веса и производные для ordern_matrix
+            return (3 * m * m + 32 * m) * sizeof(double);
+        case ORDER_TABLE_TILED:
+            // Два буфера по блоку строк V, структурированная ковариация и веса
+            return (2 * ORDER_TABLE_TILE_ROWS * m + order_structured_memory(m) / sizeof(double) + 16 * m) *
+                   sizeof(double);
+        case ORDER_TABLE_NONE:
+            break;
+    }
+    return (2 * m + 4) * sizeof(double);
+}
@@ -0,0 +1,235 @@
+#include "order.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+// Структурированная (полуразделимая) ковариация порядковых статистик
+// и обобщенный МНК за O(m) памяти без плотной матрицы m x m
+
+// ============ Генераторы ковариации ============
+// Слагаемые z1..z7 из ordern/orderw сгруппированы по множителям строки r и
+// столбца s: V(r, s) = sum_k A_k(r) B_k(s) при r <= s.
+// При усечении порядка order старшие степени 1/(n+2) обнуляются.
+static void order_generators(int n, int order, const OrderTerms& t, double* a, double* b) {
+    double p = t.p, q = t.q, d = t.q - t.p, pq = t.p * t.q;
+    double c1 = 1. / (n + 2.);
+    double c2 = (order >= 2) ? c1 * c1 : 0.0;
+    double c3 = (order >= 3) ? c1 * c1 * c1 : 0.0;
+
+    // Слагаемые со столбцовым множителем q_s x'_s (включая главный член)
+    a[0] = c1 * p * t.x1 + (c2 - c3) * p * d * t.x2 + 0.5 * c2 * p * pq * t.x3 +
+           c3 * p * (d * d - pq) * t.x3 + (5. / 6.) * c3 * p * pq * d * t.x4 +
+           0.125 * c3 * p * pq * pq * t.x5;
+    b[0] = q * t.x1;
+
+    // Слагаемые со строчным множителем p_r x'_r
+    a[1] = p * t.x1;
+    b[1] = (c2 - c3) * q * d * t.x2 + 0.5 * c2 * pq * q * t.x3 + c3 * q * (d * d - pq) * t.x3 +
+           (5. / 6.) * c3 * pq * q * d * t.x4 + 0.125 * c3 * q * pq * pq * t.x5;
+
+    // Остальные смешанные слагаемые
+    a[2] = p * p * t.x2;
+    b[2] = (0.5 * c2 - 2. * c3) * q * q * t.x2 + c3 * q * q * d * t.x3 + 0.25 * c3 * pq * q * q * t.x4;
+
+    a[3] = p * d * t.x2;
+    b[3] = 1.5 * c3 * q * d * t.x2 + 0.5 * c3 * pq * q * t.x3;
+
+    a[4] = pq * t.x2;
+    b[4] = 0.5 * c3 * pq * t.x2;
+
+    a[5] = p * p * d * t.x3;
+    b[5] = c3 * q * q * t.x2;
+
+    a[6] = p * pq * t.x3;
+    b[6] = 0.5 * c3 * q * d * t.x2 + 0.25 * c3 * pq * q * t.x3;
+
+    a[7] = p * p * pq * t.x4;
+    b[7] = 0.25 * c3 * q * q * t.x2;
+
+    a[8] = p * p * p * t.x3;
+    b[8] = (1. / 6.) * c3 * q * q * q * t.x3;
+}
+
+void order_covariance_structured(OrderFamily family, int n, const std::vector<double>& probs,
+                                 Vector& er, OrderCovariance& cov) {
+    size_t m = probs.size();
+    int order = order_expansion();
+    double ga[ORDER_GENERATORS], gb[ORDER_GENERATORS];
+
+    er.resize(m);
+    cov.n = n;
+    cov.m = m;
+    cov.order = order;
+    cov.error_bound = 0.0;
+    cov.p.resize(m);
+    cov.x1.resize(m);
+    cov.a.resize(ORDER_GENERATORS * m);
+    cov.b.resize(ORDER_GENERATORS * m);
+
+    for (size_t i = 0; i < m; i++) {
+        OrderTerms t = (family == ORDER_NORMAL) ? order_terms_normal(probs[i], order)
+                                                : order_terms_weibull(probs[i], order);
+        er(i) = order_expectation(n, t, order);
+        cov.error_bound = std::max(cov.error_bound, order_truncation_error(n, t, order));
+        cov.p[i] = t.p;
+        cov.x1[i] = t.x1;
+
+        order_generators(n, order, t, ga, gb);
+        for (int k = 0; k < ORDER_GENERATORS; k++) {
+            cov.a[k * m + i] = ga[k];
+            cov.b[k * m + i] = gb[k];
+        }
+    }
+}
+
+// ============ Произведение V z за O(K m) ============
+// (V z)_i = sum_k [ B_k(i) sum_{j<i} A_k(j) z_j + A_k(i) sum_{j>=i} B_k(j) z_j ]
+void order_covariance_apply(const OrderCovariance& cov, const double* z, double* out) {
+    size_t m = cov.m;
+
+    for (size_t i = 0; i < m; i++) out[i] = 0.0;
+
+    for (int k = 0; k < ORDER_GENERATORS; k++) {
+        const double* a = &cov.a[k * m];
+        const double* b = &cov.b[k * m];
+
+        double prefix = 0.0;
+        for (size_t i = 0; i < m; i++) {
+            out[i] += b[i] * prefix;
+            prefix += a[i] * z[i];
+        }
+        double suffix = 0.0;
+        for (size_t i = m; i-- > 0;) {
+            suffix += b[i] * z[i];
+            out[i] += a[i] * suffix;
+        }
+    }
+}
+
+// ============ Предобуславливатель ============
+// Главный член V0 = c1 D S D, D = diag(x'), S(r, s) = p_r q_s при r <= s
+// (ковариация броуновского моста). S^{-1} трехдиагональна:
+//   S^{-1}(i, i) = 1/g_{i-1} + 1/g_i,  S^{-1}(i, i+1) = -1/g_i,  g_i = p_{i+1} - p_i,
+// где p_0 = 0, p_{m+1} = 1. Поэтому y = V0^{-1} r вычисляется за O(m).
+static void order_precondition(const OrderCovariance& cov, const double* r, double* y,
+                               std::vector<double>& w) {
+    size_t m = cov.m;
+    double c = cov.n + 2.;
+
+    w.resize(m);
+    for (size_t i = 0; i < m; i++) w[i] = r[i] / cov.x1[i];
+
+    for (size_t i = 0; i < m; i++) {
+        double g_prev = cov.p[i] - (i > 0 ? cov.p[i - 1] : 0.0);
+        double g_next = (i + 1 < m ? cov.p[i + 1] : 1.0) - cov.p[i];
+        double u = (1. / g_prev + 1. / g_next) * w[i];
+        if (i > 0) u -= w[i - 1] / g_prev;
+        if (i + 1 < m) u -= w[i + 1] / g_next;
+        y[i] = c * u / cov.x1[i];
+    }
+}
+
+// Решение V z = rhs методом сопряженных градиентов с предобуславливателем V0
+int order_covariance_solve(const OrderCovariance& cov, const std::vector<double>& rhs, std::vector<double>& z) {
+    const double tol = 1e-13;
+    const int max_iter = 500;
+    size_t m = cov.m;
+
+    std::vector<double> r(rhs), y(m), p(m), ap(m), w;
+    z.assign(m, 0.0);
+
+    double rhs_norm = 0.0;
+    for (size_t i = 0; i < m; i++) rhs_norm += rhs[i] * rhs[i];
+    rhs_norm = std::sqrt(rhs_norm);
+    if (rhs_norm == 0.0) return 0;
+
+    order_precondition(cov, r.data(), y.data(), w);
+    p = y;
+    double rz = 0.0;
+    for (size_t i = 0; i < m; i++) rz += r[i] * y[i];
+
+    for (int iter = 1; iter <= max_iter; iter++) {
+        order_covariance_apply(cov, p.data(), ap.data());
+
+        double pap = 0.0;
+        for (size_t i = 0; i < m; i++) pap += p[i] * ap[i];
+        if (!(pap > 0.0)) {
+            throw std::runtime_error("Ковариационная матрица порядковых статистик не положительно определена");
+        }
+
+        double alpha = rz / pap;
+        double r_norm = 0.0;
+        for (size_t i = 0; i < m; i++) {
+            z[i] += alpha * p[i];
+            r[i] -= alpha * ap[i];
+            r_norm += r[i] * r[i];
+        }
+        if (std::sqrt(r_norm) <= tol * rhs_norm) return iter;
+
+        order_precondition(cov, r.data(), y.data(), w);
+        double rz_new = 0.0;
+        for (size_t i = 0; i < m; i++) rz_new += r[i] * y[i];
+        double beta = rz_new / rz;
+        rz = rz_new;
+        for (size_t i = 0; i < m; i++) p[i] = y[i] + beta * p[i];
+    }
+    throw std::runtime_error("Метод сопряженных градиентов не сошелся");
+}
+
+/**
+ * Обобщенный МНК со структурированной ковариацией
+ * b = (X^T V^{-1} X)^{-1} X^T V^{-1} y, где V^{-1} X находится итерационно
+ */
+int MleastSquare_structured(const Matrix& x, const Matrix& y, const OrderCovariance& v,
+                            Matrix& db, Matrix& b, Vector& yr) {
+    size_t n = x.size1();
+    size_t k = x.size2();
+    if (n != v.m || y.size1() != n) {
+        throw std::runtime_error("Несовместимые размеры матриц для взвешенного МНК");
+    }
+
+    // W = V^{-1} X по столбцам
+    Matrix w(n, k);
+    std::vector<double> col(n), sol;
+    int iterations = 0;
+    for (size_t c = 0; c < k; c++) {
+        for (size_t i = 0; i < n; i++) col[i] = x(i, c);
+        iterations = std::max(iterations, order_covariance_solve(v, col, sol));
+        for (size_t i = 0; i < n; i++) w(i, c) = sol[i];
+    }
+
+    // X^T V^{-1} X и X^T V^{-1} y
+    Matrix xt_v_inv_x(k, k);
+    Matrix xt_v_inv_y(k, y.size2());
+    for (size_t r = 0; r < k; r++) {
+        for (size_t c = 0; c < k; c++) {
+            double s = 0.0;
+            for (size_t i = 0; i < n; i++) s += w(i, r) * x(i, c);
+            xt_v_inv_x(r, c) = s;
+        }
+        for (size_t c = 0; c < y.size2(); c++) {
+            double s = 0.0;
+            for (size_t i = 0; i < n; i++) s += w(i, r) * y(i, c);
+            xt_v_inv_y(r, c) = s;
+        }
+    }
+
+    db = InverseMatrix(xt_v_inv_x);
+    b = MultiplyMatrix(db, xt_v_inv_y);
+
+    yr.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        yr(i) = 0.0;
+        for (size_t j = 0; j < k; j++) {
+            yr(i) += x(i, j) * b(j, 0);
+        }
+    }
+    return iterations;
+}
+
+size_t order_structured_memory(size_t m) {
+    // Генераторы с p и x' (2 + 2K), вероятности, ожидания, X, y, прогноз (6),
+    // V^{-1} X со столбцом и решением (4), векторы метода сопряженных градиентов (5)
+    return (2 + 2 * ORDER_GENERATORS + 15) * m * sizeof(double);
+}
@@ -0,0 +1,121 @@
+#include "thread_pool.h"
+#include <cstdlib>
+#include <memory>
+
+// Признак рабочего потока - вложенные циклы выполняются последовательно
+static thread_local bool inside_pool_worker = false;
+
+ThreadPool::ThreadPool(int threads) {
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& w : workers) {
+        w.join();
+    }
+}
+
+// Раздача итераций текущего цикла. Исключение итерации запоминается
+// (только первое) и останавливает раздачу оставшихся
+void ThreadPool::run_tasks() {
+    for (;;) {
+        size_t k = next_index.fetch_add(1);
+        if (k >= job_count) break;
+        try {
+            (*job)(k);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (!error) error = std::current_exception();
+            next_index = job_count;
+        }
+    }
+}
+
+void ThreadPool::worker_loop() {
+    inside_pool_worker = true;
+    unsigned long seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(state_mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        run_tasks();
+
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            busy_workers--;
+        }
+        done.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& body) {
+    std::unique_lock<std::mutex> submit(submit_mutex, std::defer_lock);
+    if (workers.empty() || count < 2 || inside_pool_worker || !submit.try_lock()) {
+        for (size_t k = 0; k < count; k++) body(k);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        job = &body;
+        job_count = count;
+        next_index = 0;
+        busy_workers = int(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    // Вложенные циклы из body в вызывающем потоке - последовательно
+    // (submit_mutex уже захвачен этим потоком)
+    inside_pool_worker = true;
+    run_tasks();
+    inside_pool_worker = false;
+
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        done.wait(lock, [&] { return busy_workers == 0; });
+        job = nullptr;
+        std::swap(failure, error);
+    }
+    if (failure) std::rethrow_exception(failure);
+}
+
+// ============ Общий пул процесса ============
+
+static std::unique_ptr<ThreadPool> global_pool;
+static std::mutex global_pool_mutex;
+
+static int default_thread_count() {
+    const char* env = std::getenv("AGAMIROV_THREADS");
+    if (env != nullptr && std::atoi(env) > 0) {
+        return std::atoi(env);
+    }
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? int(hw) : 1;
+}
+
+ThreadPool& global_thread_pool() {
+    std::lock_guard<std::mutex> lock(global_pool_mutex);
+    if (!global_pool) {
+        global_pool.reset(new ThreadPool(default_thread_count()));
+    }
+    return *global_pool;
+}
+
+void set_thread_count(int threads) {
+    std::lock_guard<std::mutex> lock(global_pool_mutex);
+    global_pool.reset(new ThreadPool(threads > 0 ? threads : default_thread_count()));
+}
@@ -0,0 +1,43 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cmath>
+#include <cstdio>
+
+// ========== Минимальные проверки для тестов (make test) ==========
+// Каждый тест - отдельная программа; ненулевой код возврата - ошибка.
+
+static int check_failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::fprintf(stderr, "%s:%d: не выполнено: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                                         \
+        }                                                                             \
+    } while (0)
+
+// |a - b| <= tol * max(1, |b|)
+#define CHECK_CLOSE(a, b, tol)                                                        \
+    do {                                                                              \
+        double check_a = (a), check_b = (b);                                          \
+        if (!(std::fabs(check_a - check_b) <= (tol) * std::fmax(1.0, std::fabs(check_b)))) { \
+            std::fprintf(stderr, "%s:%d: %s = %.17g, ожидалось %s = %.17g\n",         \
+                         __FILE__, __LINE__, #a, check_a, #b, check_b);               \
+            check_failures++;                                                         \
+        }                                                                             \
+    } while (0)
+
+/**
+ * Итог теста: печать и код возврата для main
+ */
+inline int check_report(const char* name) {
+    if (check_failures == 0) {
+        std::printf("%s: OK\n", name);
+        return 0;
+    }
+    std::printf("%s: ошибок %d\n", name, check_failures);
+    return 1;
+}
+
+#endif // TESTS_CHECK_H
@@ -0,0 +1,102 @@
+#include "check.h"
+#include "mle_methods.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Сотни одновременных подгонок на разных данных из нескольких std::thread:
+// результаты должны побитово совпадать с последовательным запуском
+
+struct Lot {
+    std::vector<double> normal, weibull;
+    std::vector<int> censored;      // правое цензурирование верхней четверти normal
+};
+
+struct LotResult {
+    MLEResult mle_weibull, mls_normal, mls_weibull;
+};
+
+static std::vector<Lot> make_lots(size_t count) {
+    std::mt19937_64 gen(20);
+    std::uniform_real_distribution<double> u(1e-6, 1.0 - 1e-6);
+    std::vector<Lot> lots(count);
+    for (size_t s = 0; s < count; s++) {
+        Lot& lot = lots[s];
+        size_t n = 10 + s % 51;
+        double shape = 1.0 + 0.02 * double(s % 100);
+        for (size_t i = 0; i < n; i++) {
+            lot.weibull.push_back(3.0 * std::pow(-std::log(1.0 - u(gen)), 1.0 / shape));
+            lot.normal.push_back(50.0 + 5.0 * std::sqrt(-2.0 * std::log(u(gen))) * std::cos(6.283185307179586 * u(gen)));
+        }
+        std::vector<double> sorted = lot.normal;
+        std::sort(sorted.begin(), sorted.end());
+        double cut = sorted[n - n / 4 - 1];
+        for (double x : lot.normal) lot.censored.push_back(x > cut ? 1 : 0);
+    }
+    return lots;
+}
+
+static LotResult fit(const Lot& lot) {
+    LotResult r;
+    r.mle_weibull = mle_weibull_complete(lot.weibull);
+    r.mls_normal = mls_normal_progressive(lot.normal, lot.censored);
+    r.mls_weibull = mls_weibull_complete(lot.weibull);
+    return r;
+}
+
+static bool same_bits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool same(const MLEResult& a, const MLEResult& b) {
+    if (a.parameters.size() != b.parameters.size() || a.covariance.size() != b.covariance.size()) return false;
+    for (size_t i = 0; i < a.parameters.size(); i++) {
+        if (!same_bits(a.parameters[i], b.parameters[i])) return false;
+    }
+    for (size_t i = 0; i < a.covariance.size(); i++) {
+        for (size_t j = 0; j < a.covariance.size(); j++) {
+            if (!same_bits(a.covariance(i, j), b.covariance(i, j))) return false;
+        }
+    }
+    return same_bits(a.log_likelihood, b.log_likelihood) && a.iterations == b.iterations &&
+           a.converged == b.converged;
+}
+
+int main() {
+    const size_t count = 300;
+    const int threads = 4;
+    std::vector<Lot> lots = make_lots(count);
+
+    std::vector<LotResult> serial(count);
+    for (size_t s = 0; s < count; s++) serial[s] = fit(lots[s]);
+
+    // Каждый поток берет следующую партию; пул тоже многопоточный
+    set_thread_count(threads);
+    std::vector<LotResult> concurrent(count);
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            for (size_t s; (s = next++) < count;) concurrent[s] = fit(lots[s]);
+        });
+    }
+    for (std::thread& w : workers) w.join();
+
+    int differences = 0;
+    for (size_t s = 0; s < count; s++) {
+        differences += !same(serial[s].mle_weibull, concurrent[s].mle_weibull);
+        differences += !same(serial[s].mls_normal, concurrent[s].mls_normal);
+        differences += !same(serial[s].mls_weibull, concurrent[s].mls_weibull);
+    }
+    CHECK(differences == 0);
+    for (size_t s = 0; s < count; s++) {
+        CHECK(serial[s].mle_weibull.converged);
+        CHECK(serial[s].mls_normal.parameters.size() == 2);
+    }
+    return check_report("concurrent_fits");
+}
@@ -0,0 +1,69 @@
+#include "check.h"
+#include "gls_workspace.h"
+#include "mle_methods.h"
+#include "order.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Установившийся режим GlsWorkspace: повторные оценки того же (или меньшего)
+// объема не выделяют память - счетчик allocations() не меняется.
+// n = 20, 150 и 199 - упакованная V в рабочей области; с n >= MLS_STRUCTURED_MIN_N
+// (200) MLS идет структурированным путем, который ws не использует.
+
+static std::vector<double> sample(int n, int seed) {
+    std::vector<double> x(n);
+    for (int i = 0; i < n; i++) x[i] = 100.0 + 10.0 * std::sin(0.7 * i + seed) + 0.01 * i;
+    return x;
+}
+
+static void check_size(int n) {
+    std::vector<double> fcum(n), ycum;
+    for (int i = 0; i < n; i++) fcum[i] = double(i + 1) / (n + 1);
+    double b[2], db[4];
+
+    // MleastSquare_order: первый вызов растит арену, дальше выделений нет
+    GlsWorkspace ws;
+    for (OrderFamily family : {ORDER_NORMAL, ORDER_WEIBULL}) {
+        ycum = sample(n, int(family));
+        std::sort(ycum.begin(), ycum.end());
+        MleastSquare_order(family, n, fcum.data(), ycum.data(), n, ws, b, db);
+    }
+    size_t warm = ws.allocations();
+    CHECK(warm > 0);
+    for (int repeat = 0; repeat < 5; repeat++) {
+        for (OrderFamily family : {ORDER_NORMAL, ORDER_WEIBULL}) {
+            ycum = sample(n, repeat + 2);
+            std::sort(ycum.begin(), ycum.end());
+            MleastSquare_order(family, n, fcum.data(), ycum.data(), n, ws, b, db);
+        }
+    }
+    CHECK(ws.allocations() == warm);
+
+    // Меньший объем в той же арене - тоже без выделений
+    MleastSquare_order(ORDER_NORMAL, n / 2, fcum.data(), ycum.data(), size_t(n / 2), ws, b, db);
+    CHECK(ws.allocations() == warm);
+
+    // mls_normal_complete(data, ws) и mls_weibull_complete(data, ws) в общей арене
+    GlsWorkspace fits;
+    mls_normal_complete(sample(n, 0), fits);
+    mls_weibull_complete(sample(n, 0), fits);
+    warm = fits.allocations();
+    for (int repeat = 1; repeat <= 5; repeat++) {
+        MLEResult normal = mls_normal_complete(sample(n, repeat), fits);
+        MLEResult weibull = mls_weibull_complete(sample(n, repeat), fits);
+        CHECK(normal.converged && weibull.converged);
+    }
+    CHECK(fits.allocations() == warm);
+
+    // Емкость mls_workspace_size(n) достаточна сразу: только основной блок
+    GlsWorkspace sized(mls_workspace_size(n));
+    size_t initial = sized.allocations();
+    for (int repeat = 0; repeat < 3; repeat++) mls_normal_complete(sample(n, repeat), sized);
+    CHECK(sized.allocations() == initial);
+}
+
+int main() {
+    for (int n : {20, 150, 199}) check_size(n);
+    return check_report("gls_workspace");
+}
@@ -0,0 +1,106 @@
+#include "check.h"
+#include "nelder_mead.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// Мультистарт с целевой функцией, бросающей исключение, в нескольких потоках;
+// поиск глобального минимума функции с двумя ямами, когда x0 лежит в мелкой
+
+static double rosenbrock(const std::vector<double>& x) {
+    return 100.0 * (x[1] - x[0] * x[0]) * (x[1] - x[0] * x[0]) + (1.0 - x[0]) * (1.0 - x[0]);
+}
+
+// Глубокая яма около (2.46, 1.97), мелкая - около (-1.97, -1.48)
+static double wells(std::vector<double> x) {
+    double global = (x[0] - 2.5) * (x[0] - 2.5) + (x[1] - 2.0) * (x[1] - 2.0);
+    double local = (x[0] + 2.0) * (x[0] + 2.0) + (x[1] + 1.5) * (x[1] + 1.5);
+    return -3.0 * std::exp(-global) - 1.5 * std::exp(-2.0 * local) + 0.05 * (x[0] * x[0] + x[1] * x[1]);
+}
+
+static void check_wells() {
+    std::vector<double> x0 = {-1.8, -1.2};
+    const std::vector<double> lower = {-4.0, -4.0}, upper = {4.0, 4.0};
+    MultiStartOptions options;
+
+    // Один запуск из x0 остается в мелкой яме
+    NelderMeadResult single = neldermead_detailed(x0, options.local, wells);
+    CHECK(single.parameters[0] < 0.0 && single.final_value > -1.5);
+
+    // Те же K запусков без прерывания - цена независимых подгонок
+    MultiStartOptions independent = options;
+    independent.abandon_after = options.local.max_iter + 1;
+    independent.merge_radius = 0.0;
+
+    set_thread_count(1);
+    MultiStartResult full = neldermead_multistart(x0, lower, upper, independent, wells);
+    MultiStartResult result = neldermead_multistart(x0, lower, upper, options, wells);
+    CHECK(full.abandoned == 0);
+    CHECK(result.best_start != 0);
+    CHECK_CLOSE(result.best.parameters[0], 2.4589, 1e-3);
+    CHECK_CLOSE(result.best.parameters[1], 1.9671, 1e-3);
+    CHECK(result.best.final_value < single.final_value - 1.0);
+    CHECK_CLOSE(result.best.final_value, full.best.final_value, 1e-9);
+    CHECK(result.abandoned > 0);
+    CHECK(result.evaluations < options.starts * single.counters.evaluations);
+    CHECK(result.evaluations < 0.6 * full.evaluations);
+
+    // В одном потоке результат воспроизводится побитово
+    MultiStartResult again = neldermead_multistart(x0, lower, upper, options, wells);
+    CHECK(std::memcmp(again.best.parameters.data(), result.best.parameters.data(), 2 * sizeof(double)) == 0);
+    CHECK(again.best.final_value == result.best.final_value);
+    CHECK(again.best_start == result.best_start);
+    CHECK(again.abandoned == result.abandoned);
+    CHECK(again.converged == result.converged);
+    CHECK(again.evaluations == result.evaluations);
+
+    // В нескольких потоках прерываются, возможно, другие запуски, но минимум тот же
+    set_thread_count(4);
+    MultiStartResult parallel = neldermead_multistart(x0, lower, upper, options, wells);
+    CHECK_CLOSE(parallel.best.parameters[0], 2.4589, 1e-3);
+    CHECK_CLOSE(parallel.best.parameters[1], 1.9671, 1e-3);
+}
+
+int main() {
+    check_wells();
+
+    set_thread_count(4);
+    const std::vector<double> x0 = {-1.0, 2.0}, lower = {-2.0, -2.0}, upper = {2.0, 3.0};
+    MultiStartOptions options;
+
+    // Исключение на вызове fail: при оценке точек плана (fail <= starts) и внутри запусков
+    for (int fail : {1, 5, 40, 300}) {
+        std::atomic<int> calls{0};
+        bool thrown = false;
+        try {
+            neldermead_multistart(x0, lower, upper, options, [&](std::vector<double> x) {
+                if (++calls == fail) throw std::runtime_error("ошибка целевой функции");
+                return rosenbrock(x);
+            });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+
+    // После исключений мультистарт работает как обычно
+    MultiStartResult result = neldermead_multistart(x0, lower, upper, options, rosenbrock);
+    CHECK(result.best.converged);
+    CHECK_CLOSE(result.best.parameters[0], 1.0, 1e-4);
+    CHECK_CLOSE(result.best.parameters[1], 1.0, 1e-4);
+
+    set_thread_count(1);
+    bool thrown = false;
+    try {
+        neldermead_multistart(x0, lower, upper, options, [](std::vector<double> x) -> double {
+            if (x[0] > 0.5) throw std::runtime_error("ошибка целевой функции");
+            return rosenbrock(x);
+        });
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    return check_report("multistart");
+}
@@ -0,0 +1,163 @@
+#include "check.h"
+#include "nelder_mead_batch.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// neldermead_batch против neldermead<2> по каждой выборке на той же функции
+// (neldermead_batch_value): параметры, значение, итерации и счетчики шагов
+// побитово равны. Нормальная модель и Вейбулл, полные и цензурированные выборки;
+// число выборок не кратно числу дорожек, размеры перемешаны (дозагрузка дорожек
+// и дополнение до общего числа строк). Каждое доступное ядро - против generic.
+
+// Воспроизводимые выборки: splitmix64 (не зависит от реализации <random>)
+static std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double uniform(std::uint64_t& state) {
+    return (double(splitmix64(state) >> 11) + 0.5) * 0x1.0p-53;
+}
+
+struct Lots {
+    std::vector<std::vector<double>> x;
+    std::vector<std::vector<int>> r;
+    std::vector<FitContext> contexts;
+    std::vector<std::array<double, 2>> x0;
+};
+
+/**
+ * count выборок размером 3..60 вперемешку; при цензурировании наблюдения
+ * выше порога заменяются порогом (тип I), а каждое 5-е - цензурировано
+ */
+static Lots make_lots(BatchModel model, size_t count, bool censored) {
+    Lots lots;
+    lots.x.resize(count);
+    lots.r.resize(count);
+    std::uint64_t state = 77 + count * 2 + (censored ? 1 : 0) + (model == BATCH_MODEL_WEIBULL ? 1000 : 0);
+    for (size_t t = 0; t < count; t++) {
+        int n = 3 + int((t * 37 + count) % 58);
+        std::vector<double>& x = lots.x[t];
+        std::vector<int>& r = lots.r[t];
+        x.resize(n);
+        double location = 10.0 * uniform(state) - 5.0;
+        double spread = 0.2 + 3.0 * uniform(state);
+        for (int i = 0; i < n; i++) {
+            double u = uniform(state);
+            if (model == BATCH_MODEL_WEIBULL) {
+                x[i] = std::exp(location) * std::pow(-std::log(u), 1.0 / spread);
+            } else {
+                double v = uniform(state);
+                x[i] = location + spread * std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * M_PI * v);
+            }
+        }
+        if (censored) {
+            r.assign(n, 0);
+            std::vector<double> sorted = x;
+            std::sort(sorted.begin(), sorted.end());
+            double cut = sorted[n - 1 - n / 4];
+            for (int i = 0; i < n; i++) {
+                if (x[i] > cut || i % 5 == 4) {
+                    x[i] = std::min(x[i], cut);
+                    r[i] = 1;
+                }
+            }
+        }
+        if (model == BATCH_MODEL_WEIBULL) {
+            lots.x0.push_back({1.0 + 0.1 * double(t % 3), 1.0});
+        } else {
+            lots.x0.push_back({x[0], 1.0 + 0.1 * double(t % 3)});
+        }
+    }
+    for (size_t t = 0; t < count; t++) lots.contexts.emplace_back(lots.x[t], lots.r[t]);
+    return lots;
+}
+
+static bool same_result(const NelderMeadFixedResult<2>& a, const NelderMeadFixedResult<2>& b) {
+    return std::memcmp(a.parameters.data(), b.parameters.data(), sizeof(a.parameters)) == 0 &&
+           std::memcmp(&a.final_value, &b.final_value, sizeof(double)) == 0 &&
+           a.iterations == b.iterations && a.converged == b.converged &&
+           a.counters.evaluations == b.counters.evaluations &&
+           a.counters.reflections == b.counters.reflections &&
+           a.counters.expansions == b.counters.expansions &&
+           a.counters.contractions == b.counters.contractions &&
+           a.counters.shrinks == b.counters.shrinks;
+}
+
+static const char* kernel_name(BatchKernel kernel) {
+    switch (kernel) {
+        case BATCH_KERNEL_AVX512: return "avx512";
+        case BATCH_KERNEL_AVX2:   return "avx2";
+        default:                  return "generic";
+    }
+}
+
+static void check_model(BatchModel model, bool censored, const NelderMeadOptions& options) {
+    const size_t counts[] = {1, 7, 13, 37, 150};
+    const BatchKernel kernels[] = {BATCH_KERNEL_GENERIC, BATCH_KERNEL_AVX2, BATCH_KERNEL_AVX512};
+
+    for (size_t count : counts) {
+        Lots lots = make_lots(model, count, censored);
+        std::vector<NelderMeadFixedResult<2>> generic;
+
+        for (BatchKernel kernel : kernels) {
+            neldermead_batch_set_kernel(kernel);
+            if (neldermead_batch_active_kernel() != kernel) continue;   // нет на процессоре
+
+            NelderMeadBatchReport report;
+            std::vector<NelderMeadFixedResult<2>> batch =
+                neldermead_batch(model, lots.contexts, lots.x0, options, &report);
+            CHECK(batch.size() == count);
+            CHECK(std::strcmp(report.kernel, kernel_name(kernel)) == 0);
+            CHECK(report.lane_evaluations <= report.vector_evaluations * (long long)NELDER_MEAD_BATCH_LANES);
+
+            long long evaluations = 0;
+            for (size_t t = 0; t < count; t++) {
+                NelderMeadFixedResult<2> single = neldermead<2>(
+                    lots.x0[t], options, lots.contexts[t],
+                    [model](const FitContext& ctx, const std::array<double, 2>& p) {
+                        return neldermead_batch_value(model, ctx, p);
+                    });
+                CHECK(same_result(batch[t], single));
+                CHECK(std::isfinite(batch[t].final_value));
+                evaluations += single.counters.evaluations;
+            }
+            CHECK(report.lane_evaluations == evaluations);
+
+            if (kernel == BATCH_KERNEL_GENERIC) {
+                generic = batch;
+            } else {
+                for (size_t t = 0; t < count; t++) CHECK(same_result(batch[t], generic[t]));
+            }
+        }
+    }
+    neldermead_batch_set_kernel(BATCH_KERNEL_AUTO);
+}
+
+int main() {
+    NelderMeadOptions options;
+    options.eps = 1e-9;
+    options.max_iter = 400;
+
+    // Несколько частей пакета - по потокам пула
+    set_thread_count(4);
+    check_model(BATCH_MODEL_NORMAL, false, options);
+    check_model(BATCH_MODEL_NORMAL, true, options);
+    check_model(BATCH_MODEL_WEIBULL, false, options);
+    check_model(BATCH_MODEL_WEIBULL, true, options);
+    set_thread_count(1);
+
+    // Значение вне области параметров
+    std::vector<double> x = {1.0, 2.0, 3.0};
+    FitContext ctx(x, std::vector<int>());
+    CHECK(std::isinf(neldermead_batch_value(BATCH_MODEL_NORMAL, ctx, {2.0, 0.0})));
+    CHECK(std::isinf(neldermead_batch_value(BATCH_MODEL_WEIBULL, ctx, {-1.0, 2.0})));
+
+    return check_report("nelder_mead_batch");
+}
@@ -0,0 +1,164 @@
+#include "check.h"
+#include "mle_methods.h"
+#include "small_matrix.h"
+#include "trust_region.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+// Регрессия mle_normal_censored (Ньютон с доверительной областью) против
+// Нелдера-Мида: neldermead<2> из тех же начальных оценок по точному -log L
+// с eps = 1e-12. Прежний путь mls_normal_censored (квадрат уравнений
+// правдоподобия, NormalMinValue) на выборках с цензурированием типа I
+// останавливался в точках с log L ниже на 2-10, поэтому эталон - по -log L.
+// Выборки - input/data_censored_normal.txt, тип I (верхняя четверть) и
+// прогрессивное цензурирование. Ковариация - против обращения гессиана -log L
+// по конечным разностям.
+
+struct NormalSample {
+    int n;
+    double mu, sigma;
+    int censoring;      // 1 - тип I (верхняя четверть), 2 - прогрессивное (каждое 3-е)
+};
+
+static const NormalSample samples[] = {
+    {10, 0.0, 1.0, 1}, {25, 100.0, 5.0, 2}, {60, -3.0, 0.5, 1}, {150, 1e3, 50.0, 2}, {400, 2.0, 3.0, 1},
+};
+
+// (μ, σ, log L) Нелдера-Мида: файл, затем samples[]
+static const double reference[][3] = {
+    {103.09476733516266, 6.7659806064570125, -69.743328055578047},
+    {-0.060907681628970034, 1.0365276024181027, -13.737961177093288},
+    {100.76673838682294, 6.3241577692281687, -60.991805171634645},
+    {-2.9453908516950591, 0.48305390176267815, -45.081175797020002},
+    {1017.689661329129, 55.686093415396932, -572.5931306193703},
+    {2.0858928218575121, 3.0642462765068501, -854.82137037541168},
+};
+
+// Воспроизводимые выборки: splitmix64 и Бокс-Мюллер (не зависят от реализации <random>)
+static std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double uniform(std::uint64_t& state) {
+    return (double(splitmix64(state) >> 11) + 0.5) * 0x1.0p-53;
+}
+
+static void make_sample(size_t index, std::vector<double>& x, std::vector<int>& r) {
+    const NormalSample& s = samples[index];
+    std::uint64_t state = 2200 + index;
+    x.assign(s.n, 0.0);
+    r.assign(s.n, 0);
+    for (int i = 0; i < s.n; i++) {
+        double u = uniform(state), v = uniform(state);
+        x[i] = s.mu + s.sigma * std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * M_PI * v);
+    }
+    if (s.censoring == 1) {
+        std::vector<double> sorted = x;
+        std::sort(sorted.begin(), sorted.end());
+        double cut = sorted[s.n - s.n / 4 - 1];
+        for (int i = 0; i < s.n; i++) {
+            if (x[i] > cut) {
+                x[i] = cut;
+                r[i] = 1;
+            }
+        }
+    } else {
+        for (int i = 2; i < s.n; i += 3) r[i] = 1;
+    }
+}
+
+// -log L без производных
+static double normal_nll(const std::vector<double>& x, const std::vector<int>& r, double mu, double sigma) {
+    double f = 0.0;
+    for (size_t i = 0; i < x.size(); i++) {
+        double z = (x[i] - mu) / sigma;
+        if (r[i] == 0) {
+            f += std::log(sigma) + 0.5 * std::log(2.0 * M_PI) + 0.5 * z * z;
+        } else {
+            f -= std::log(0.5 * std::erfc(z / std::sqrt(2.0)));
+        }
+    }
+    return f;
+}
+
+static void check_sample(const std::vector<double>& x, const std::vector<int>& r, const double* expected) {
+    MLEResult result = mle_normal_censored(x, r);
+    CHECK(result.converged);
+    CHECK(result.iterations <= 12);
+    CHECK(result.parameters.size() == 2);
+    CHECK_CLOSE(result.parameters[0], expected[0], 1e-7);
+    CHECK_CLOSE(result.parameters[1], expected[1], 1e-7);
+    CHECK_CLOSE(result.log_likelihood, expected[2], 1e-12);
+    CHECK(result.log_likelihood >= expected[2] - 1e-12 * std::fabs(expected[2]));
+
+    // Гессиан -log L центральными разностями с шагом 1e-4 σ
+    const double mu = result.parameters[0], sigma = result.parameters[1];
+    const double step[2] = {1e-4 * sigma, 1e-4 * sigma};
+    Mat2 hessian;
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            double f[4];
+            for (int k = 0; k < 4; k++) {
+                double p[2] = {mu, sigma};
+                p[i] += (k < 2 ? 1.0 : -1.0) * step[i];
+                p[j] += (k % 2 == 0 ? 1.0 : -1.0) * step[j];
+                f[k] = normal_nll(x, r, p[0], p[1]);
+            }
+            hessian(i, j) = (f[0] - f[1] - f[2] + f[3]) / (4.0 * step[i] * step[j]);
+        }
+    }
+    Mat2 covariance = inverse(hessian);
+
+    CHECK(result.covariance.size() == 2);
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            double scale = std::sqrt(covariance(i, i) * covariance(j, j));
+            CHECK(std::fabs(result.covariance(i, j) - covariance(i, j)) <= 1e-5 * scale);
+        }
+    }
+}
+
+// Гессиан с nan: сдвиг lambda не помогает, поиск должен остановиться
+static void check_nan_hessian() {
+    TrustRegionOptions options;
+    options.max_iter = 1000000;
+    TrustRegionResult<2> tr = newton_trust_region(std::array<double, 2>{1.0, 2.0}, options,
+        [](const std::array<double, 2>& x, std::array<double, 2>& g, Mat2& h) {
+            g = {x[0], x[1]};
+            h = Mat2::identity();
+            h(0, 1) = h(1, 0) = std::numeric_limits<double>::quiet_NaN();
+            return 0.5 * (x[0] * x[0] + x[1] * x[1]);
+        });
+    CHECK(!tr.converged);
+    CHECK(tr.evaluations < 10);
+    CHECK(tr.parameters[0] == 1.0 && tr.parameters[1] == 2.0);
+}
+
+int main() {
+    std::vector<double> x;
+    std::vector<int> r;
+    std::ifstream in("input/data_censored_normal.txt");
+    double value;
+    int indicator;
+    while (in >> value >> indicator) {
+        x.push_back(value);
+        r.push_back(indicator);
+    }
+    CHECK(x.size() == 25);
+    if (!x.empty()) check_sample(x, r, reference[0]);
+
+    for (size_t s = 0; s < sizeof(samples) / sizeof(samples[0]); s++) {
+        make_sample(s, x, r);
+        check_sample(x, r, reference[s + 1]);
+    }
+
+    check_nan_hessian();
+    return check_report("normal_censored");
+}
@@ -0,0 +1,78 @@
+#include "check.h"
+#include "order.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Векторные ядра строк ковариации порядковых статистик против скалярного
+// эталона и поэлементной order_covariance. Ядра используют FMA, поэтому
+// совпадение не побитовое: допуск 1e-13 относительно sqrt(v_ii v_jj).
+
+static const double TOLERANCE = 1e-13;
+
+// Наибольшее отклонение a от b в единицах sqrt(b_ii b_jj)
+static double max_deviation(const Matrix& a, const Matrix& b) {
+    double worst = 0.0;
+    for (size_t i = 0; i < b.size1(); i++) {
+        for (size_t j = 0; j < b.size2(); j++) {
+            double scale = std::sqrt(b(i, i) * b(j, j));
+            worst = std::max(worst, std::fabs(a(i, j) - b(i, j)) / scale);
+        }
+    }
+    return worst;
+}
+
+static void check_family(OrderFamily family, int n) {
+    std::vector<double> probs(n);
+    for (int i = 0; i < n; i++) probs[i] = double(i + 1) / (n + 1);
+
+    auto build = [&](OrderKernel kernel, Vector& er, Matrix& v) {
+        order_set_kernel(kernel);
+        if (family == ORDER_NORMAL) {
+            ordern_matrix(n, probs, er, v);
+        } else {
+            orderw_matrix(n, probs, er, v);
+        }
+    };
+
+    Vector er_scalar;
+    Matrix v_scalar;
+    build(ORDER_KERNEL_SCALAR, er_scalar, v_scalar);
+    CHECK(order_active_kernel() == ORDER_KERNEL_SCALAR);
+
+    // Скалярный путь - поэлементная формула order_covariance (порядок по умолчанию)
+    std::vector<OrderTerms> terms(n);
+    for (int i = 0; i < n; i++) {
+        terms[i] = (family == ORDER_NORMAL) ? order_terms_normal(probs[i]) : order_terms_weibull(probs[i]);
+    }
+    Matrix v_formula(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = i; j < n; j++) {
+            v_formula(i, j) = v_formula(j, i) = order_covariance(n, terms[i], terms[j]);
+        }
+    }
+    CHECK(max_deviation(v_scalar, v_formula) <= TOLERANCE);
+
+    for (OrderKernel kernel : {ORDER_KERNEL_AVX2, ORDER_KERNEL_AVX512}) {
+        order_set_kernel(kernel);
+        if (order_active_kernel() != kernel) continue;     // нет на процессоре
+        Vector er;
+        Matrix v;
+        build(kernel, er, v);
+        double deviation = max_deviation(v, v_scalar);
+        if (!(deviation <= TOLERANCE)) {
+            std::fprintf(stderr, "n = %d, ядро %d: отклонение %.3g\n", n, int(kernel), deviation);
+        }
+        CHECK(deviation <= TOLERANCE);
+        CHECK(max_deviation(v, v_formula) <= TOLERANCE);
+        for (int i = 0; i < n; i++) CHECK(er(i) == er_scalar(i));
+    }
+}
+
+int main() {
+    for (OrderFamily family : {ORDER_NORMAL, ORDER_WEIBULL}) {
+        for (int n : {3, 20, 137, 1000}) check_family(family, n);
+    }
+    order_set_kernel(ORDER_KERNEL_AUTO);
+    return check_report("order_kernels");
+}
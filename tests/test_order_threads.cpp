@@ -0,0 +1,84 @@
+#include "check.h"
+#include "order.h"
+#include "thread_pool.h"
+#include <cstring>
+#include <vector>
+
+// Ковариация порядковых статистик не зависит от числа потоков: плотная
+// и упакованная матрицы ordern_matrix/orderw_matrix и блоки order_matrix_tiled
+// при 1 и 8 потоках побитово равны. n = 700 - несколько блоков 128 x 128,
+// включая неполный последний; для каждого доступного ядра.
+
+struct OrderOutput {
+    std::vector<double> er, dense, packed, tiled;
+};
+
+static std::vector<double> copy_vector(const Vector& v) {
+    return std::vector<double>(v.begin(), v.end());
+}
+
+static OrderOutput build(OrderFamily family, int n, const std::vector<double>& probs) {
+    OrderOutput out;
+    Vector er;
+    Matrix v;
+    SymmetricMatrix packed;
+    if (family == ORDER_NORMAL) {
+        ordern_matrix(n, probs, er, v);
+        ordern_matrix(n, probs, er, packed);
+    } else {
+        orderw_matrix(n, probs, er, v);
+        orderw_matrix(n, probs, er, packed);
+    }
+    out.er = copy_vector(er);
+    out.dense.assign(v.data().begin(), v.data().end());
+    out.packed.assign(packed.data().begin(), packed.data().end());
+
+    size_t m = probs.size();
+    out.tiled.assign(m * m, 0.0);
+    order_matrix_tiled(family, n, probs, 100, er, [&](size_t i0, size_t i1, const double* rows) {
+        std::memcpy(&out.tiled[i0 * m], rows, (i1 - i0) * m * sizeof(double));
+    });
+    return out;
+}
+
+static bool same_bits(const std::vector<double>& a, const std::vector<double>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+
+static void check_family(OrderFamily family, int n, const std::vector<double>& probs) {
+    for (OrderKernel kernel : {ORDER_KERNEL_SCALAR, ORDER_KERNEL_AVX2, ORDER_KERNEL_AVX512}) {
+        order_set_kernel(kernel);
+        if (order_active_kernel() != kernel) continue;     // нет на процессоре
+
+        set_thread_count(1);
+        OrderOutput single = build(family, n, probs);
+        set_thread_count(8);
+        OrderOutput parallel = build(family, n, probs);
+
+        size_t m = probs.size();
+        CHECK(single.dense.size() == m * m);
+        CHECK(single.packed.size() == m * (m + 1) / 2);
+        CHECK(same_bits(single.er, parallel.er));
+        CHECK(same_bits(single.dense, parallel.dense));
+        CHECK(same_bits(single.packed, parallel.packed));
+        CHECK(same_bits(single.tiled, parallel.tiled));
+        CHECK(same_bits(single.tiled, single.dense));
+    }
+    order_set_kernel(ORDER_KERNEL_AUTO);
+    set_thread_count(1);
+}
+
+int main() {
+    const int n = 700;
+    std::vector<double> probs(n);
+    for (int i = 0; i < n; i++) probs[i] = double(i + 1) / (n + 1);
+
+    // Цензурированная выборка: первые 550 порядковых статистик из 700
+    std::vector<double> censored(probs.begin(), probs.begin() + 550);
+
+    for (OrderFamily family : {ORDER_NORMAL, ORDER_WEIBULL}) {
+        check_family(family, n, probs);
+        check_family(family, n, censored);
+    }
+    return check_report("order_threads");
+}
@@ -0,0 +1,49 @@
+#include "check.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <stdexcept>
+
+// Исключения из тела цикла и вложенные циклы при нескольких потоках
+
+static void check_pool(int threads) {
+    ThreadPool pool(threads);
+    const size_t count = 1000;
+
+    // Исключение в одной итерации (в любом потоке) - передается вызывающему
+    for (size_t bad : {size_t(0), size_t(37), count - 1}) {
+        std::atomic<size_t> started{0};
+        bool thrown = false;
+        try {
+            pool.parallel_for(count, [&](size_t k) {
+                started++;
+                if (k == bad) throw std::runtime_error("ошибка итерации");
+            });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        CHECK(started <= count);
+    }
+
+    // Исключение во всех итерациях - в том числе в вызывающем потоке
+    bool thrown = false;
+    try {
+        pool.parallel_for(count, [](size_t) { throw std::logic_error("все итерации"); });
+    } catch (const std::logic_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    // После исключений пул работает; вложенные циклы - последовательно, без взаимоблокировки
+    std::atomic<size_t> sum{0};
+    pool.parallel_for(count, [&](size_t k) {
+        pool.parallel_for(3, [&](size_t j) { sum += k * 3 + j; });
+    });
+    CHECK(sum == (3 * count) * (3 * count - 1) / 2);
+}
+
+int main() {
+    check_pool(1);
+    check_pool(4);
+    return check_report("thread_pool");
+}
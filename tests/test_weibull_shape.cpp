@@ -0,0 +1,114 @@
+#include "check.h"
+#include "mle_methods.h"
+#include "root_solver.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Регрессия weibull_shape_mle против прежних оценок Нелдера-Мида:
+// neldermead<1>(1.5) по WeibullMinValue с eps = 1e-10 (совпадают с корнем,
+// найденным бисекцией в long double, до 3e-11). Выборки - полные, тип II
+// и прогрессивное цензурирование; не более 12 проходов по данным.
+
+// Воспроизводимые выборки: splitmix64 и обратное преобразование (не зависят от реализации <random>)
+struct WeibullSample {
+    int n;
+    double scale, shape;
+    int censoring;      // 0 - полная, 1 - тип II (верхняя четверть), 2 - прогрессивное (каждое 3-е)
+};
+
+static const WeibullSample samples[] = {
+    {5, 1.0, 2.0, 0},     {10, 0.01, 0.5, 0},  {20, 100.0, 1.0, 0},   {50, 3.0, 3.5, 0},
+    {100, 1e3, 10.0, 0},  {300, 1e-3, 0.3, 0}, {12, 1.0, 1.5, 1},     {40, 50.0, 0.7, 1},
+    {200, 2.0, 6.0, 1},   {30, 0.1, 2.5, 2},   {90, 7.0, 1.2, 2},     {250, 1e2, 4.0, 2},
+};
+
+static std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void make_sample(size_t index, std::vector<double>& x, std::vector<int>& r) {
+    const WeibullSample& s = samples[index];
+    std::uint64_t state = 1000 + index;
+    x.assign(s.n, 0.0);
+    r.assign(s.n, 0);
+    for (int i = 0; i < s.n; i++) {
+        double u = (double(splitmix64(state) >> 11) + 0.5) * 0x1.0p-53;
+        x[i] = s.scale * std::pow(-std::log(u), 1.0 / s.shape);
+    }
+    if (s.censoring == 1) {
+        std::vector<double> sorted = x;
+        std::sort(sorted.begin(), sorted.end());
+        double cut = sorted[s.n - s.n / 4 - 1];
+        for (int i = 0; i < s.n; i++) {
+            if (x[i] > cut) {
+                x[i] = cut;
+                r[i] = 1;
+            }
+        }
+    } else if (s.censoring == 2) {
+        for (int i = 2; i < s.n; i += 3) r[i] = 1;
+    }
+}
+
+// (λ, k) прежнего Нелдера-Мида для samples[]
+static const double reference[][2] = {
+    {0.87416820049045463, 2.7638904801104207},
+    {0.0098583358322725835, 0.89974457588978152},
+    {89.350810742328008, 0.83385954180266753},
+    {3.0152857960840516, 3.4768188377609466},
+    {992.3243533613969, 9.541482388344587},
+    {0.00077973309971073057, 0.29787051232997402},
+    {1.5438913092310973, 2.3980489769484841},
+    {35.288949031026746, 0.80859584386926175},
+    {1.9873403435735286, 5.5638256375445012},
+    {0.12025557305603295, 2.427557508903555},
+    {8.9596699878951931, 1.0579367528669537},
+    {107.59570121753165, 3.9866990078939111},
+};
+
+int main() {
+    const size_t count = sizeof(samples) / sizeof(samples[0]);
+    for (size_t s = 0; s < count; s++) {
+        std::vector<double> x;
+        std::vector<int> r;
+        make_sample(s, x, r);
+        FitContext ctx(x, r);
+
+        RootResult root = weibull_shape_mle(ctx, 1.5);
+        CHECK(root.converged);
+        CHECK(root.evaluations <= 12);
+
+        // Масштаб при найденной форме: λ^k = Σ x^k / (число отказов)
+        double b = root.root, sum = 0.0;
+        int k = 0;
+        for (int i = 0; i < ctx.n; i++) {
+            sum += std::pow(x[i], b);
+            k += (r[i] == 0);
+        }
+        double scale = std::pow(sum / k, 1.0 / b);
+        CHECK_CLOSE(b / reference[s][1], 1.0, 1e-7);
+        CHECK_CLOSE(scale / reference[s][0], 1.0, 1e-7);
+
+        if (samples[s].censoring == 0) {
+            MLEResult mle = mle_weibull_complete(x);
+            CHECK(mle.converged);
+            CHECK(mle.iterations <= 12);
+            CHECK_CLOSE(mle.parameters[0] / reference[s][0], 1.0, 1e-7);
+            CHECK_CLOSE(mle.parameters[1] / reference[s][1], 1.0, 1e-7);
+        }
+    }
+
+    // newton_bracketed: корень кубического уравнения x^3 - 2x - 5 = 0 на [2, 3]
+    RootResult cubic = newton_bracketed(2.0, 3.0, 2.5, [](double t, double& d) {
+        d = 3.0 * t * t - 2.0;
+        return t * t * t - 2.0 * t - 5.0;
+    });
+    CHECK(cubic.converged);
+    CHECK_CLOSE(cubic.root, 2.0945514815423265, 1e-15);
+    return check_report("weibull_shape");
+}